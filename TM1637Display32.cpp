@@ -18,210 +18,3240 @@ extern "C" {
 #include <TM1637Display32.h>
 #include <Arduino.h>
 
+#if TM1637_HAS_PIO
+#include <hardware/clocks.h>
+#endif
+
+#if TM1637_FAST_GPIO && defined(ARDUINO_ARCH_RP2040)
+#include <hardware/structs/sio.h>
+#elif TM1637_FAST_GPIO && defined(ESP32)
+#include <soc/gpio_reg.h>
+#endif
+
+#if TM1637_HAS_RMT
+#include <driver/gpio.h>
+#endif
+
 #define TM1637_I2C_COMM1    0x40
 #define TM1637_I2C_COMM2    0xC0
 #define TM1637_I2C_COMM3    0x80
+#define TM1637_I2C_FIXED    0x04  // COMM1 flag: fixed address instead of auto-increment
+#define TM1637_READ_KEYS    0x42  // Data command: read key scan data
+
+#define TM1637_INFLIGHT_COMM3 0x80  // m_inflight flag: frame ends with display control
+
+// Memory barrier for the mailbox sequence count (compiler-only on single-core AVR)
+#if defined(__AVR__)
+#define TM1637_FENCE() __asm__ __volatile__("" ::: "memory")
+#else
+#define TM1637_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+#ifdef TM1637_RAM_BUDGET
+static_assert(sizeof(TM1637Display32) <= TM1637_RAM_BUDGET,
+              "TM1637Display32 outgrew TM1637_RAM_BUDGET");
+#endif
+
+// The one TM1637Layout this build defines (see the header)
+template <unsigned long LAYOUT, unsigned TRACE, unsigned WAVE_CACHE>
+TM1637Layout<LAYOUT, TRACE, WAVE_CACHE>::TM1637Layout() {}
+template struct TM1637Layout<TM1637_LAYOUT, TM1637_TRACE, TM1637_WAVE_CACHE>;
+static_assert(TM1637_POST_SLOTS >= 0 && TM1637_POST_SLOTS <= 8, "TM1637_POST_SLOTS must be 0-8");
+static_assert(TM1637_MAX_DIGITS >= 1 && TM1637_MAX_DIGITS <= 6, "TM1637_MAX_DIGITS must be 1-6");
+static_assert(TM1637_SCROLL_COPY >= 1 && TM1637_SCROLL_COPY <= 254, "TM1637_SCROLL_COPY must be 1-254");
+
+#if TM1637_STATS
+// Stats are written inside an odd/even sequence bracket so getStats() can retry
+#define TM1637_STAT(stmt) do { m_statsSeq++; TM1637_FENCE(); stmt; TM1637_FENCE(); m_statsSeq++; } while (0)
+#if defined(ESP32)
+#define TM1637_CYCLES() ESP.getCycleCount()
+#elif defined(ARDUINO_ARCH_RP2040)
+#define TM1637_CYCLES() rp2040.getCycleCount()
+#elif defined(F_CPU)
+#define TM1637_CYCLES() (micros() * (F_CPU / 1000000UL))  // No cycle counter
+#else
+#define TM1637_CYCLES() micros()
+#endif
+#else
+#define TM1637_STAT(stmt) do {} while (0)
+#endif
+
+// Minimum microseconds between state changes
+// TM1637 datasheet specifies ~1µs minimum, but we use more for reliability
+// ESP32/RP2040 require longer delays for reliable non-blocking operation
+#if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
+#define BIT_DELAY_US 100  // Matches proven 10kHz ISR timing; gives margin for RTOS preemption
+#else
+#define BIT_DELAY_US 0    // AVR is slow enough that no delay needed
+#endif
+#define TM1637_CALIBRATE_MAX_US 800  // Slowest step time calibrateBitDelay() tries
+
+#define TM1637_CLK          0  // Line index for lineLow()/lineRelease()
+#define TM1637_DIO          1
+
+#if TM1637_HAS_PIO
+// PIO program (hand-assembled pioasm output):
+//
+//   .program tm1637
+//   .side_set 1 opt pindirs        ; side-set = CLK, OUT/SET = DIO
+//   entry:                         ; pindir 1 drives LOW, 0 releases to pull-up
+//       pull block                 ; header: bits 0-7 = bytes-1, then up to 3 bytes (inverted)
+//       out x, 8
+//       set pindirs, 1      [7]    ; START: DIO LOW while CLK HIGH
+//       jmp byte_start
+//   byte_loop:
+//       pull ifempty block         ; next 4 data bytes (inverted) once the word is used up
+//   byte_start:
+//       set y, 7
+//   bit_loop:
+//       nop          side 1 [7]    ; CLK LOW
+//       out pindirs, 1      [7]    ; DIO = data bit (LSB first)
+//       jmp y-- bit_loop side 0 [7] ; CLK HIGH (TM1637 samples)
+//       nop          side 1 [7]    ; CLK LOW for ACK
+//       set pindirs, 0      [7]    ; release DIO, TM1637 pulls it LOW
+//       nop          side 0 [7]    ; CLK HIGH for ACK
+//       nop          side 1 [7]    ; CLK LOW after ACK
+//       jmp x-- byte_loop
+//       set pindirs, 1      [7]    ; DIO LOW
+//       nop          side 0 [7]    ; CLK HIGH
+//       set pindirs, 0      [7]    ; STOP: DIO rises while CLK HIGH
+//
+// Every transition is 8 PIO cycles; beginPIO() derives the clock divider from that.
+static const uint16_t tm1637_program_instructions[] = {
+  0x80a0,  //  0: pull   block
+  0x6028,  //  1: out    x, 8
+  0xe781,  //  2: set    pindirs, 1      [7]
+  0x0005,  //  3: jmp    5
+  0x80e0,  //  4: pull   ifempty block
+  0xe047,  //  5: set    y, 7
+  0xbf42,  //  6: nop           side 1 [7]
+  0x6781,  //  7: out    pindirs, 1      [7]
+  0x1786,  //  8: jmp    y--, 6  side 0 [7]
+  0xbf42,  //  9: nop           side 1 [7]
+  0xe780,  // 10: set    pindirs, 0      [7]
+  0xb742,  // 11: nop           side 0 [7]
+  0xbf42,  // 12: nop           side 1 [7]
+  0x0044,  // 13: jmp    x--, 4
+  0xe781,  // 14: set    pindirs, 1      [7]
+  0xb742,  // 15: nop           side 0 [7]
+  0xe780,  // 16: set    pindirs, 0      [7]
+};
+
+static const struct pio_program tm1637_program = {
+  .instructions = tm1637_program_instructions,
+  .length = 17,
+  .origin = -1,
+};
+
+#define TM1637_PIO_CYCLES_PER_STEP 8
+#define TM1637_PIO_WRAP 16
+
+// Queue one START/bytes/STOP block: the header word carries the byte count
+// and the first three bytes, later bytes go four to a word (all inverted:
+// a 1 bit drives DIO LOW)
+static void pioPutBlock(PIO pio, uint sm, uint8_t first, const uint8_t* data, uint8_t count) {
+  uint32_t word = (uint32_t)count | ((uint32_t)(uint8_t)~first << 8);  // count = bytes - 1
+  uint8_t shift = 16;
+  for (uint8_t i = 0; i < count; i++) {
+    word |= (uint32_t)(uint8_t)~data[i] << shift;
+    shift += 8;
+    if (shift == 32) {
+      pio_sm_put(pio, sm, word);
+      word = 0;
+      shift = 0;
+    }
+  }
+  if (shift != 0) pio_sm_put(pio, sm, word);
+}
+#endif
+
+#if TM1637_HAS_RMT
+// Symbols per line for one rendered transaction. A 6-digit frame needs about
+// 90 for CLK (one symbol per clock, nine clocks per byte) plus the reset prefix.
+#define TM1637_RMT_SYMBOLS  128
+
+// Run-length encoder for one line of a pre-rendered waveform
+struct RmtTrack {
+  rmt_symbol_word_t* symbols;
+  uint16_t halves;  // Level/duration pairs written so far
+  uint8_t level;    // Level of the run being accumulated
+  uint32_t run;     // Ticks accumulated at that level
+};
+
+static void rmtFlush(RmtTrack& t) {
+  while (t.run > 0 && t.halves < TM1637_RMT_SYMBOLS * 2) {
+    uint16_t ticks = (t.run > 32767) ? 32767 : t.run;  // 15-bit duration field
+    rmt_symbol_word_t& w = t.symbols[t.halves >> 1];
+    if ((t.halves & 1) == 0) {
+      w.level0 = t.level;
+      w.duration0 = ticks;
+      w.level1 = t.level;
+      w.duration1 = 0;  // End marker unless the second half gets filled
+    } else {
+      w.level1 = t.level;
+      w.duration1 = ticks;
+    }
+    t.halves++;
+    t.run -= ticks;
+  }
+  t.run = 0;
+}
+
+static void rmtEmit(RmtTrack& t, uint8_t level, uint32_t ticks) {
+  if (level != t.level) {
+    rmtFlush(t);
+    t.level = level;
+  }
+  t.run += ticks;
+}
+
+static void rmtEmitLines(RmtTrack& clk, RmtTrack& dio, uint8_t lines, uint32_t ticks) {
+  rmtEmit(clk, (lines & TM1637_LINE_CLK) ? 1 : 0, ticks);
+  rmtEmit(dio, (lines & TM1637_LINE_DIO) ? 1 : 0, ticks);
+}
+#endif
+
+// Font lookup tables, built at compile time from the constexpr font in the
+// header: the only copy runtime lookups read
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define TM1637_PROGMEM PROGMEM
+#define TM1637_PGM_READ(p) pgm_read_byte(p)
+#define TM1637_PGM_READ32(p) pgm_read_dword(p)
+#else
+#define TM1637_PROGMEM
+#define TM1637_PGM_READ(p) (*(p))
+#define TM1637_PGM_READ32(p) (*(p))
+#endif
+
+#if __cplusplus < 201703L
+// The font's one out-of-class definition, for labels encoded at run time
+constexpr uint8_t tm1637_detail::Font::digits[16];
+constexpr uint8_t tm1637_detail::Font::letters[26];
+#endif
+
+#define TM1637_D(d) tm1637_detail::encodeDigit(d)
+static const uint8_t digitToSegment[16] TM1637_PROGMEM = {
+  TM1637_D(0),  TM1637_D(1),  TM1637_D(2),  TM1637_D(3),
+  TM1637_D(4),  TM1637_D(5),  TM1637_D(6),  TM1637_D(7),
+  TM1637_D(8),  TM1637_D(9),  TM1637_D(10), TM1637_D(11),
+  TM1637_D(12), TM1637_D(13), TM1637_D(14), TM1637_D(15)
+};
+#undef TM1637_D
+
+static const uint8_t minusSegments = 0b01000000;
+
+// Printable ASCII (0x20-0x7f) -> segments, so charToSeg() is one bounds check
+#define TM1637_C(c) tm1637_detail::encodeChar(c)
+#define TM1637_C8(c) TM1637_C(c),     TM1637_C(c + 1), TM1637_C(c + 2), TM1637_C(c + 3), \
+                     TM1637_C(c + 4), TM1637_C(c + 5), TM1637_C(c + 6), TM1637_C(c + 7)
+static const uint8_t asciiToSegment[96] TM1637_PROGMEM = {
+  TM1637_C8(0x20), TM1637_C8(0x28), TM1637_C8(0x30), TM1637_C8(0x38),
+  TM1637_C8(0x40), TM1637_C8(0x48), TM1637_C8(0x50), TM1637_C8(0x58),
+  TM1637_C8(0x60), TM1637_C8(0x68), TM1637_C8(0x70), TM1637_C8(0x78)
+};
+#undef TM1637_C8
+#undef TM1637_C
+
+// Powers of ten for decimalDigits(), largest first
+static const uint32_t powersOfTen[9] TM1637_PROGMEM = {
+  1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL
+};
+
+// Decimal digits of value, least significant first, by repeated subtraction:
+// at most 9 compare/subtracts per digit and no division (AVR has no divide
+// instruction, a 32-bit one costs ~600 cycles). Returns the number of
+// significant digits (at least 1).
+static uint8_t decimalDigits(uint32_t value, uint8_t digits[10]) {
+  uint8_t count = 1;
+  for (uint8_t i = 0; i < 9; i++) {
+    uint32_t power = TM1637_PGM_READ32(&powersOfTen[i]);
+    uint8_t digit = 0;
+    while (value >= power) {
+      value -= power;
+      digit++;
+    }
+    digits[9 - i] = digit;
+    if (digit != 0 && count == 1) count = 10 - i;
+  }
+  digits[0] = (uint8_t)value;
+  return count;
+}
+
+// Drop the n least significant of count digits, rounding half up on the
+// first of them (rounding once, so 2.1449 goes to 2.1, not 2.2)
+static void dropDigits(uint8_t digits[], uint8_t& count, uint8_t n) {
+  bool roundUp = digits[n - 1] >= 5;
+  for (uint8_t k = n; k < count; k++) digits[k - n] = digits[k];
+  count -= n;
+  for (uint8_t k = 0; roundUp; k++) {
+    if (k == count) {
+      digits[count++] = 1;  // 9.95 -> 10.0
+      break;
+    }
+    roundUp = ++digits[k] == 10;
+    if (roundUp) digits[k] = 0;
+  }
+}
+
+// Release a line for open-drain signalling: input with pull-up, output latch LOW
+static void pinSetup(uint8_t pin) {
+  #if TM1637_FAST_GPIO && defined(ESP32)
+  // Route the pin to the GPIO output matrix once; lineLow() only flips enables.
+  // The latch is written after that: before it, the pin is not a GPIO yet.
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  #else
+  // Pre-set output latch to LOW (for when we switch to OUTPUT mode)
+  digitalWrite(pin, LOW);
+  #endif
+
+  // Pins are set as inputs with pull-ups for open-drain signaling
+  #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
+  pinMode(pin, INPUT_PULLUP);
+  #else
+  pinMode(pin, INPUT);
+  #endif
+
+  #if TM1637_FAST_GPIO && defined(ARDUINO_ARCH_RP2040)
+  sio_hw->gpio_clr = 1u << pin;  // Output latch LOW
+  #endif
+}
+
+// pinMode() line toggling, for TM1637_FAST_GPIO=0 builds and pins without a cached register
+static void pinLow(uint8_t pin) {
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);  // Explicit LOW for ESP32
+}
+
+static void pinRelease(uint8_t pin) {
+  #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
+  pinMode(pin, INPUT_PULLUP);  // ESP32/RP2040 need explicit internal pull-ups
+  #else
+  pinMode(pin, INPUT);
+  #endif
+}
+
+#if TM1637_FAST_GPIO
+// Output-enable registers of a pin: writing mask to oeSet drives it LOW,
+// writing it to oeClr releases it (on AVR both are DDRx, read-modify-write)
+static void pinRegisters(uint8_t pin, tm1637_reg_t** oeSet, tm1637_reg_t** oeClr,
+                         tm1637_mask_t* mask) {
+  #if defined(__AVR__)
+  *oeSet = portModeRegister(digitalPinToPort(pin));
+  *oeClr = *oeSet;
+  *mask = digitalPinToBitMask(pin);
+  #elif defined(ARDUINO_ARCH_RP2040)
+  *oeSet = &sio_hw->gpio_oe_set;
+  *oeClr = &sio_hw->gpio_oe_clr;
+  *mask = 1u << pin;
+  #elif defined(ESP32)
+  #ifdef GPIO_ENABLE1_W1TS_REG
+  if (pin >= 32) {
+    *oeSet = (tm1637_reg_t*)GPIO_ENABLE1_W1TS_REG;
+    *oeClr = (tm1637_reg_t*)GPIO_ENABLE1_W1TC_REG;
+    *mask = 1u << (pin - 32);
+    return;
+  }
+  #endif
+  *oeSet = (tm1637_reg_t*)GPIO_ENABLE_W1TS_REG;
+  *oeClr = (tm1637_reg_t*)GPIO_ENABLE_W1TC_REG;
+  *mask = 1u << pin;
+  #endif
+}
+
+// Input register of a pin, read with the mask pinRegisters() returns
+static const tm1637_reg_t* pinInputRegister(uint8_t pin) {
+  #if defined(__AVR__)
+  return portInputRegister(digitalPinToPort(pin));
+  #elif defined(ARDUINO_ARCH_RP2040)
+  return &sio_hw->gpio_in;
+  #elif defined(ESP32)
+  #ifdef GPIO_IN1_REG
+  return (const tm1637_reg_t*)(pin >= 32 ? GPIO_IN1_REG : GPIO_IN_REG);
+  #else
+  return (const tm1637_reg_t*)GPIO_IN_REG;
+  #endif
+  #endif
+}
+#endif
+
+TM1637Display32::TM1637Display32(uint8_t pinClk, uint8_t pinDIO, uint8_t digits) {
+  m_pinClk = pinClk;
+  m_pinDIO = pinDIO;
+  m_brightness = 0x0F;  // Max brightness (7) + display ON (0x08)
+  m_counter = 255;  // Idle state (no transmission pending)
+  if (digits < 1) digits = 1;
+  if (digits > TM1637_MAX_DIGITS) digits = TM1637_MAX_DIGITS;
+  m_digitCount = digits;
+  for (uint8_t i = 0; i < TM1637_MAX_DIGITS; i++) m_digitMap[i] = i;  // Position n on GRIDn+1
+  #if TM1637_POST_SLOTS
+  memset(m_slots, 0, sizeof(m_slots));  // Ticket 0 everywhere: nothing to take
+  memset(m_slotTaken, 0, sizeof(m_slotTaken));
+  #if TM1637_POST_SLOTS > 1
+  m_postTicket = 0;
+  #endif
+  #endif
+  m_digitsSet = 0;
+  m_posted = false;
+  m_postedBrightness = m_brightness;
+  m_resendRequests = 0;
+  m_resendsDone = 0;
+  #if TM1637_HOOKS
+  m_postHook = NULL;
+  m_postHookCtx = NULL;
+  #endif
+  m_claimed = 0;
+  #if TM1637_SPINLOCK
+  static spin_lock_t* lock = NULL;  // One for every display; a striped one once they are all taken
+  if (!lock) {
+    int num = spin_lock_claim_unused(false);
+    lock = spin_lock_instance(num >= 0 ? (uint)num : next_striped_spin_lock_num());
+  }
+  m_postLock = lock;
+  #endif
+  m_segmentsValid = 0;  // Chip contents unknown until the first frame
+  m_inflight = 0;
+  m_chipBrightness = 0xFF;
+  m_fixedAddr = false;
+  m_lines = TM1637_LINE_CLK | TM1637_LINE_DIO;  // Bus idle: both lines released
+  m_linesOut = m_lines;
+  m_bitDelayUs = BIT_DELAY_US;
+  #if TM1637_RETRIES
+  m_nacks = 0;
+  m_ackCheck = true;
+  m_retries = 2;
+  m_retriesLeft = m_retries;
+  #endif
+  m_error = TM1637_ERR_NONE;
+  m_framesDone = 0;
+  #if TM1637_STATS
+  m_statsSeq = 0;
+  m_statsReset = false;
+  m_statsInFlight = false;
+  m_statsUnsent = false;
+  m_postMicros = 0;
+  m_frameMicros = 0;
+  statsClear();
+  #endif
+  #if TM1637_TRACE
+  m_traceHead = 0;
+  m_traceCount = 0;
+  m_traceFrozen = false;
+  m_traceMicros = 0;
+  #endif
+  #if TM1637_WAVE_CACHE
+  for (uint8_t i = 0; i < TM1637_WAVE_CACHE; i++) m_wave[i].steps = 0;
+  m_waveClock = 0;
+  m_waveCodes = NULL;
+  m_waveStep = 0;
+  m_waveSteps = 0;
+  #endif
+  m_lastUpdateMicros = 0;
+  #if TM1637_RETRIES || TM1637_WATCHDOG
+  m_gapStartMicros = 0;
+  #endif
+  #if TM1637_THROTTLE
+  m_lastTransmissionMillis = 0;
+  m_minIntervalMillis = 0;  // No throttle by default
+  #endif
+  #if TM1637_WATCHDOG
+  m_transmissionStartMillis = 0;
+  m_timeoutMs = 500;
+  #if TM1637_PACING
+  m_watchdogTicks = 0;
+  m_frameTicks = 0;
+  #endif
+  #endif
+  #if TM1637_KEYS
+  m_keyIntervalMs = 0;  // No key scanning until setKeyScan()
+  m_keyDebounce = 2;
+  m_keyLastScan = 0;
+  m_keyScanning = false;
+  m_keyByte = 0;
+  m_keyCandidate = TM1637_NO_KEY;
+  m_keyCount = 0;
+  m_key = TM1637_NO_KEY;
+  m_keyHead = 0;
+  m_keyTail = 0;
+  #endif
+  #if TM1637_PACING
+  m_tickUs = 0;  // Clock-read timing until setTickPeriod()
+  m_paceTicks = 1;
+  m_paceCount = 0;
+  m_gapSteps = 0;
+  m_gapCount = 0;
+  m_stepsPerTick = 1;
+  m_stepSpinUs = 0;
+  #endif
+  #if TM1637_SCROLL
+  m_scrollActive = false;
+  m_scrollCtx = NULL;
+  m_scrollLength = 0;
+  m_animSource = ANIM_NONE;
+  m_animData.frames = NULL;
+  m_animCount = 0;
+  m_animIndex = 0;
+  m_animMode = TM1637_PLAY_ONCE;
+  m_animDir = 1;
+  m_animStart = 0;
+  m_animDurationUs = 0;
+  #if TM1637_HOOKS
+  m_animHook = NULL;
+  m_animHookCtx = NULL;
+  #endif
+  m_animStops = 0;
+  m_animStopsDone = 0;
+  #endif
+  #if TM1637_EFFECTS
+  m_fading = false;
+  m_fadeTarget = 0;
+  m_fadeOn = true;
+  m_fadeStart = 0;
+  m_fadeIntervalUs = 0;
+  m_blinking = false;
+  m_blinkOff = false;
+  m_blinkLeft = 0;
+  m_blinkStart = 0;
+  m_blinkOnUs = 0;
+  m_blinkOffUs = 0;
+  m_effectStops = 0;
+  m_effectStopsDone = 0;
+  m_brightnessRequest = 0;
+  m_blinkStops = 0;
+  m_blinkStopsDone = 0;
+  #endif
+  #if TM1637_HAS_PIO
+  m_pioActive = false;
+  m_pioFrame = false;
+  #endif
+  #if TM1637_HAS_RMT
+  m_rmtActive = false;
+  #endif
+  #if TM1637_HAS_TIMER
+  m_timerActive = false;
+  #endif
+
+  pinSetup(m_pinClk);
+  pinSetup(m_pinDIO);
+
+  #if TM1637_FAST_GPIO
+  // Cache the output-enable registers so a line toggle is a single store.
+  // The pull-ups configured in pinSetup() live in the pad/port config and stay on.
+  #if defined(__AVR__)
+  tm1637_reg_t* oeClr;  // Same DDRx as m_oeSet
+  pinRegisters(m_pinClk, &m_oeSet[TM1637_CLK], &oeClr, &m_mask[TM1637_CLK]);
+  pinRegisters(m_pinDIO, &m_oeSet[TM1637_DIO], &oeClr, &m_mask[TM1637_DIO]);
+  #else
+  pinRegisters(m_pinClk, &m_oeSet[TM1637_CLK], &m_oeClr[TM1637_CLK], &m_mask[TM1637_CLK]);
+  pinRegisters(m_pinDIO, &m_oeSet[TM1637_DIO], &m_oeClr[TM1637_DIO], &m_mask[TM1637_DIO]);
+  #endif
+  m_dioIn = pinInputRegister(m_pinDIO);
+  #endif
+}
+
+void TM1637Display32::lineLow(uint8_t line) {
+  #if TM1637_FAST_GPIO && defined(__AVR__)
+  uint8_t oldSREG = SREG;  // DDRx read-modify-write, same guard as pinMode()
+  cli();
+  *m_oeSet[line] |= m_mask[line];
+  SREG = oldSREG;
+  #elif TM1637_FAST_GPIO
+  *m_oeSet[line] = m_mask[line];  // Enable output, latch is already LOW
+  #else
+  pinLow(line ? m_pinDIO : m_pinClk);
+  #endif
+}
+
+void TM1637Display32::lineRelease(uint8_t line) {
+  #if TM1637_FAST_GPIO && defined(__AVR__)
+  uint8_t oldSREG = SREG;
+  cli();
+  *m_oeSet[line] &= ~m_mask[line];
+  SREG = oldSREG;
+  #elif TM1637_FAST_GPIO
+  *m_oeClr[line] = m_mask[line];  // Disable output, pull-up takes the line HIGH
+  #else
+  pinRelease(line ? m_pinDIO : m_pinClk);
+  #endif
+}
+
+bool TM1637Display32::dioHigh() const {
+  #if TM1637_FAST_GPIO
+  return (*m_dioIn & m_mask[TM1637_DIO]) != 0;
+  #else
+  return digitalRead(m_pinDIO) != LOW;
+  #endif
+}
+
+void TM1637Display32::setBrightness(uint8_t brightness, bool on) {
+  brightness = (brightness & 0x7) | (on ? 0x08 : 0x00);
+  #if TM1637_EFFECTS
+  if (m_fading || m_blinking || m_effectStops != m_effectStopsDone) {
+    // An effect step may be rewriting m_brightness: hand the stop and the
+    // new value to whoever steps the effects next (us, if nobody is now)
+    m_brightnessRequest = brightness;
+    TM1637_FENCE();
+    m_effectStops++;
+    if (tryClaim()) {
+      effectStops();
+      releaseClaim();
+    }
+    return;
+  }
+  #endif
+  m_brightness = brightness;
+}
+
+void TM1637Display32::setSegments(const uint8_t segments[], uint8_t length, uint8_t pos) {
+  queuePost(segments, length, pos);
+
+  // Start it right away if the bus is free, otherwise update() picks it up
+  // once the frame in flight has finished. Never blocks, never aborts.
+  kick();
+  notifyPost();
+}
+
+void TM1637Display32::setDigitOrder(const uint8_t order[]) {
+  for (uint8_t i = 0; i < m_digitCount; i++) m_digitMap[i] = order[i] % TM1637_MAX_DIGITS;
+}
+
+uint8_t TM1637Display32::getDigitCount() const {
+  return m_digitCount;
+}
+
+// The mailbox is kept by grid, so the chip side never sees the board's order
+uint8_t TM1637Display32::mapDigits(const uint8_t segments[], uint8_t length, uint8_t pos,
+                                   uint8_t digits[]) const {
+  uint8_t digitsSet = 0;
+  for (uint8_t i = 0; i < length && pos + i < m_digitCount; i++) {
+    uint8_t grid = m_digitMap[pos + i];
+    digits[grid] = segments[i];
+    digitsSet |= (1 << grid);
+  }
+  return digitsSet;
+}
+
+// Interrupts off on this core for the few stores of a post (see queuePost())
+#if defined(__AVR__)
+typedef uint8_t tm1637_irq_t;
+static inline tm1637_irq_t irqMask() { uint8_t oldSREG = SREG; cli(); return oldSREG; }
+static inline void irqRestore(tm1637_irq_t oldSREG) { SREG = oldSREG; }
+#elif defined(ARDUINO_ARCH_RP2040)
+typedef uint32_t tm1637_irq_t;
+static inline tm1637_irq_t irqMask() { return save_and_disable_interrupts(); }  // PRIMASK
+static inline void irqRestore(tm1637_irq_t irq) { restore_interrupts(irq); }
+#elif defined(ESP32) || defined(ESP_PLATFORM)
+typedef UBaseType_t tm1637_irq_t;
+static inline tm1637_irq_t irqMask() { return portSET_INTERRUPT_MASK_FROM_ISR(); }
+static inline void irqRestore(tm1637_irq_t irq) { portCLEAR_INTERRUPT_MASK_FROM_ISR(irq); }
+#elif defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+typedef uint32_t tm1637_irq_t;
+static inline tm1637_irq_t irqMask() {
+  uint32_t primask;
+  __asm__ __volatile__("mrs %0, primask\n\tcpsid i" : "=r"(primask) :: "memory");
+  return primask;
+}
+static inline void irqRestore(tm1637_irq_t primask) {
+  __asm__ __volatile__("msr primask, %0" :: "r"(primask) : "memory");
+}
+#else
+typedef uint8_t tm1637_irq_t;  // Host build: threads stand in for cores, a slot each
+static inline tm1637_irq_t irqMask() { return 0; }
+static inline void irqRestore(tm1637_irq_t) {}
+#endif
+
+#if TM1637_POST_SLOTS > 1
+// True if ticket a was taken after ticket b (tickets wrap)
+static inline bool postNewer(tm1637_post_t a, tm1637_post_t b) {
+  return (tm1637_post_t)(a - b - 1) < (tm1637_post_t)((tm1637_post_t)~0 >> 1);
+}
+#endif
+
+// Post from a producer, which does not hold the claim, into the slot of the
+// core it runs on. Interrupts are masked for the stores, so nothing else on
+// this core writes the slot meanwhile, and the other core never does.
+void TM1637Display32::queuePost(const uint8_t segments[], uint8_t length, uint8_t pos) {
+  #if TM1637_STATS
+  if (!m_posted) m_postMicros = micros();
+  #endif
+  uint8_t digits[TM1637_MAX_DIGITS];
+  uint8_t digitsSet = mapDigits(segments, length, pos, digits);
+  tm1637_irq_t irq = irqMask();
+  #if TM1637_POST_SLOTS
+  uint8_t s = TM1637_POST_SLOTS > 1 ? TM1637_CORE_ID() % TM1637_POST_SLOTS : 0;
+  PostSlot& slot = m_slots[s];
+  tm1637_post_t ticket = takeTicket();
+  slot.seq++;
+  TM1637_FENCE();
+  if (slot.post.ticket == m_slotTaken[s]) slot.post.digitsSet = 0;  // All taken: start afresh
+  for (uint8_t grid = 0; grid < TM1637_MAX_DIGITS; grid++) {
+    if (!(digitsSet & (1 << grid))) continue;
+    slot.post.digits[grid] = digits[grid];
+    #if TM1637_POST_SLOTS > 1
+    slot.post.tickets[grid] = ticket;
+    #endif
+  }
+  slot.post.digitsSet |= digitsSet;
+  slot.post.brightness = m_brightness;
+  slot.post.ticket = ticket;
+  TM1637_FENCE();
+  slot.seq++;
+  #else
+  applyPost(digits, digitsSet, m_brightness);  // No slots: the masked mailbox is the post
+  #endif
+  irqRestore(irq);
+  TM1637_FENCE();
+  m_posted = true;
+}
+
+#if TM1637_POST_SLOTS
+// Caller has masked interrupts on its core
+tm1637_post_t TM1637Display32::takeTicket() {
+  #if TM1637_POST_SLOTS > 1 && TM1637_SPINLOCK
+  spin_lock_unsafe_blocking(m_postLock);  // No atomic increment on the M0+
+  tm1637_post_t ticket = ++m_postTicket;
+  spin_unlock_unsafe(m_postLock);
+  return ticket;
+  #elif TM1637_POST_SLOTS > 1
+  return __atomic_add_fetch(&m_postTicket, 1, __ATOMIC_ACQ_REL);
+  #else
+  return m_slots[0].post.ticket + 1;  // One slot, and the mask keeps it ours
+  #endif
+}
+#endif
+
+// Take what the slots hold beyond what was taken from them before: for each
+// digit the value with the newest ticket across the slots. A slot caught
+// mid-write is left for later (its producer sets m_posted again when done).
+void TM1637Display32::drainPosts() {
+  #if TM1637_POST_SLOTS
+  Post posts[TM1637_POST_SLOTS];
+  uint8_t fresh = 0;  // Slots copied whole, with posts not taken yet
+  for (uint8_t s = 0; s < TM1637_POST_SLOTS; s++) {
+    PostSlot& slot = m_slots[s];
+    uint8_t seq = slot.seq;
+    if (seq & 1) continue;
+    TM1637_FENCE();
+    memcpy(&posts[s], &slot.post, sizeof(Post));
+    TM1637_FENCE();
+    if (slot.seq != seq || posts[s].ticket == m_slotTaken[s]) continue;  // Torn, or nothing new
+    fresh |= 1 << s;
+  }
+  if (!fresh) return;
+
+  #if TM1637_POST_SLOTS == 1
+  m_slotTaken[0] = posts[0].ticket;
+  applyPost(posts[0].digits, posts[0].digitsSet, posts[0].brightness);
+  #else
+  uint8_t digits[TM1637_MAX_DIGITS];
+  tm1637_post_t newest[TM1637_MAX_DIGITS];
+  uint8_t digitsSet = 0;
+  int8_t latest = -1;  // Slot with the newest post, for the brightness
+  for (uint8_t s = 0; s < TM1637_POST_SLOTS; s++) {
+    if (!(fresh & (1 << s))) continue;
+    const Post& post = posts[s];
+    for (uint8_t grid = 0; grid < TM1637_MAX_DIGITS; grid++) {
+      uint8_t bit = 1 << grid;
+      if (!(post.digitsSet & bit) || !postNewer(post.tickets[grid], m_slotTaken[s])) continue;
+      if ((digitsSet & bit) && !postNewer(post.tickets[grid], newest[grid])) continue;
+      digits[grid] = post.digits[grid];
+      newest[grid] = post.tickets[grid];
+      digitsSet |= bit;
+    }
+    if (latest < 0 || postNewer(post.ticket, posts[latest].ticket)) latest = s;
+    m_slotTaken[s] = post.ticket;
+  }
+  applyPost(digits, digitsSet, posts[latest].brightness);
+  #endif
+  #endif
+}
+
+// Caller holds the claim, or has masked interrupts without slots
+void TM1637Display32::applyPost(const uint8_t digits[], uint8_t digitsSet, uint8_t brightness) {
+  #if TM1637_STATS
+  if (m_statsUnsent) TM1637_STAT(m_stats.framesSuperseded++);
+  m_statsUnsent = true;
+  #endif
+  for (uint8_t grid = 0; grid < TM1637_MAX_DIGITS; grid++) {
+    if (digitsSet & (1 << grid)) m_digits[grid] = digits[grid];
+  }
+  m_digitsSet |= digitsSet;
+  m_postedBrightness = brightness;
+}
+
+// Post from the animation engine and the brightness effects, which hold the
+// claim already: after whatever producers queued before, straight in
+void TM1637Display32::postSegments(const uint8_t segments[], uint8_t length, uint8_t pos) {
+  #if TM1637_STATS
+  if (!m_posted) m_postMicros = micros();
+  #endif
+  uint8_t digits[TM1637_MAX_DIGITS];
+  uint8_t digitsSet = mapDigits(segments, length, pos, digits);
+  drainPosts();
+  #if TM1637_POST_SLOTS
+  applyPost(digits, digitsSet, m_brightness);
+  #else
+  tm1637_irq_t irq = irqMask();  // Producers write the mailbox too
+  applyPost(digits, digitsSet, m_brightness);
+  irqRestore(irq);
+  #endif
+  TM1637_FENCE();
+  m_posted = true;
+}
+
+// Start the newest posted frame if the bus is free and nobody else is
+// starting one right now (the other party will pick it up instead)
+void TM1637Display32::kick() {
+  if (!tryClaim()) return;
+  do {
+    if (busy()) drainPosts();  // Takes the posts while a frame is in flight
+    else launch();
+    releaseClaim();
+    // A producer that posted while we held the claim left its frame to us
+  } while (m_posted && !busy() && tryClaim());
+}
+
+// Bring the mailbox up to date and start its transaction.
+// Caller holds the claim and has checked the bus is free.
+void TM1637Display32::launch() {
+  if (!m_posted) return;
+  m_posted = false;
+  TM1637_FENCE();
+  drainPosts();
+  #if TM1637_STATS
+  m_statsUnsent = false;
+  #endif
+
+  uint8_t resend = m_resendRequests;
+  if (resend != m_resendsDone) {
+    m_segmentsValid = 0;
+    m_chipBrightness = 0xFF;
+    m_resendsDone = resend;
+  }
+  #if TM1637_POST_SLOTS
+  if (!prepareFrame(m_digits, m_digitsSet, m_postedBrightness)) return;  // Already on the chip
+  #else
+  // Producers write the mailbox in place: take a copy they cannot tear
+  uint8_t digits[TM1637_MAX_DIGITS];
+  tm1637_irq_t irq = irqMask();
+  memcpy(digits, m_digits, sizeof(digits));
+  uint8_t digitsSet = m_digitsSet;
+  uint8_t brightness = m_postedBrightness;
+  irqRestore(irq);
+  if (!prepareFrame(digits, digitsSet, brightness)) return;  // Already on the chip
+  #endif
+
+  #if TM1637_WATCHDOG
+  m_transmissionStartMillis = millis();  // For watchdog timeout
+  #if TM1637_PACING
+  m_frameTicks = 0;
+  #endif
+  #endif
+  #if TM1637_THROTTLE
+  m_lastTransmissionMillis = millis();  // For update throttling
+  #endif
+  #if TM1637_STATS
+  // COMM1, then COMM2 + data (one COMM2 per digit in fixed address mode), then COMM3
+  uint8_t digitCount = 0;
+  for (uint8_t digit = 0; digit < TM1637_MAX_DIGITS; digit++) {
+    if (m_inflight & (1 << digit)) digitCount++;
+  }
+  uint8_t bytes = (m_inflight & TM1637_INFLIGHT_COMM3) ? 1 : 0;
+  if (digitCount) bytes += 1 + (m_fixedAddr ? 2 * digitCount : 1 + digitCount);
+  TM1637_STAT(m_stats.framesStarted++; m_stats.bytesSent += bytes);
+  if (!m_statsInFlight) m_frameMicros = m_postMicros;  // A retry keeps its origin
+  m_statsInFlight = true;
+  #endif
+
+  #if TM1637_HAS_PIO
+  if (m_pioActive) {
+    // PIO owns the bus: queue the whole transaction, no ISR ticks needed
+    pioCount();  // The bus is free, so the previous frame ran out
+    pioWriteFrame();
+    m_pioFrame = true;  // Counted once the state machine is idle again
+    return;
+  }
+  #endif
+
+  #if TM1637_HAS_RMT
+  if (m_rmtActive) {
+    // RMT owns the bus: render the whole transaction and play it out in hardware
+    rmtWriteFrame(false);  // Counted by rmtDone() once both channels are through
+    return;
+  }
+  #endif
+
+  // update() generates START and everything after it
+  #if TM1637_WAVE_CACHE
+  waveStart();
+  #else
+  m_phase = 9;
+  m_counter = 0;  // Start transmission (must be last!)
+  #endif
+  #if TM1637_HAS_TIMER
+  if (m_timerActive) timerArm();
+  #endif
+}
+
+#if TM1637_WAVE_CACHE
+// Start the transaction prepareFrame() set up as a replay of its edge list,
+// rendering it by running step() once if it is not cached yet
+void TM1637Display32::waveStart() {
+  WaveEntry* entry = NULL;
+  uint8_t key[sizeof(entry->key)];
+  memset(key, 0, sizeof(key));
+  key[0] = m_inflight;
+  key[1] = m_fixedAddr;
+  key[2] = m_pos;
+  key[3] = m_length;
+  key[4] = (m_inflight & TM1637_INFLIGHT_COMM3) ? m_chipBrightness : 0;
+  for (uint8_t digit = 0; digit < TM1637_MAX_DIGITS; digit++) {
+    if (m_inflight & (1 << digit)) key[6 + digit] = m_segments[digit];
+  }
+
+  WaveEntry* victim = &m_wave[0];
+  for (uint8_t i = 0; i < TM1637_WAVE_CACHE; i++) {
+    WaveEntry& e = m_wave[i];
+    if (e.steps != 0 && memcmp(e.key, key, sizeof(key)) == 0) {
+      entry = &e;
+      break;
+    }
+    if (victim->steps == 0) continue;  // Empty entries go first
+    if (e.steps == 0 || (uint8_t)(m_waveClock - e.used) > (uint8_t)(m_waveClock - victim->used)) {
+      victim = &e;
+    }
+  }
+
+  m_lines = TM1637_LINE_CLK | TM1637_LINE_DIO;  // Every transaction starts from an idle bus
+  if (entry != NULL) {
+    TM1637_STAT(m_stats.waveCacheHits++);
+  } else {
+    // Render: record what each step does to the lines instead of driving them
+    uint8_t pos = m_pos;
+    entry = victim;
+    entry->steps = 0;
+    memset(entry->codes, 0, sizeof(entry->codes));
+    m_phase = 9;
+    m_counter = 0;
+    uint16_t n = 0;
+    bool done;
+    do {
+      uint8_t code = (m_counter == 5) ? 3 : 0;  // ACK sample point, see tick()
+      uint8_t before = m_lines;
+      done = step();
+      if (code == 0) code = m_lines ^ before;
+      if (n == sizeof(entry->codes) * 4) break;
+      entry->codes[n >> 2] |= code << ((n & 3) * 2);
+      n++;
+    } while (!done);
+    m_lines = TM1637_LINE_CLK | TM1637_LINE_DIO;
+    if (!done) {
+      // Does not fit (cannot happen with TM1637_MAX_DIGITS digits): run it live
+      m_pos = pos;
+      m_phase = 9;
+      m_counter = 0;
+      return;
+    }
+    memcpy(entry->key, key, sizeof(key));
+    entry->steps = n;
+    TM1637_STAT(m_stats.waveCacheMisses++);
+  }
+  entry->used = ++m_waveClock;
+
+  m_waveCodes = entry->codes;
+  m_waveStep = 0;
+  m_waveSteps = entry->steps;
+  m_phase = 15;
+  m_counter = 0;  // Start transmission (must be last!)
+}
+#endif
+
+// Non-blocking claim on starting a frame, shared by producers and update()
+bool TM1637Display32::tryClaim() {
+  #if TM1637_SPINLOCK
+  tm1637_irq_t irq = irqMask();           // This core
+  spin_lock_unsafe_blocking(m_postLock);  // The other core, held for a load and a store
+  bool claimed = !m_claimed;
+  m_claimed = 1;
+  spin_unlock_unsafe(m_postLock);
+  irqRestore(irq);
+  return claimed;
+  #elif defined(__AVR__) || defined(__ARM_ARCH_6M__)
+  tm1637_irq_t irq = irqMask();  // Single core, no exclusive access instructions
+  bool claimed = !m_claimed;
+  m_claimed = 1;
+  irqRestore(irq);
+  return claimed;
+  #else
+  return __atomic_exchange_n(&m_claimed, 1, __ATOMIC_ACQUIRE) == 0;
+  #endif
+}
+
+void TM1637Display32::releaseClaim() {
+  #if TM1637_SPINLOCK
+  __mem_fence_release();
+  m_claimed = 0;
+  #elif defined(__AVR__) || defined(__ARM_ARCH_6M__)
+  TM1637_FENCE();
+  m_claimed = 0;
+  #else
+  __atomic_store_n(&m_claimed, 0, __ATOMIC_RELEASE);
+  #endif
+}
+
+// Transmission in progress on whichever transport owns the bus
+bool TM1637Display32::busy() const {
+  #if TM1637_HAS_PIO
+  if (m_pioActive) return !pioIdle();
+  #endif
+  #if TM1637_HAS_RMT
+  if (m_rmtActive) return m_rmtPending != 0;
+  #endif
+  return m_counter != 255;
+}
+
+// Digits whose requested content is not (known to be) on the chip
+uint8_t TM1637Display32::dirtyDigits(const uint8_t digits[], uint8_t digitsSet) const {
+  uint8_t dirty = 0;
+  for (uint8_t digit = 0; digit < TM1637_MAX_DIGITS; digit++) {
+    uint8_t bit = 1 << digit;
+    if ((digitsSet & bit) &&
+        (!(m_segmentsValid & bit) || m_segments[digit] != digits[digit])) {
+      dirty |= bit;
+    }
+  }
+  return dirty;
+}
+
+// Work out the cheapest way to bring the chip up to date with a mailbox snapshot.
+// Copies the dirty digits into m_segments (which then mirrors the chip),
+// sets m_pos/m_length/m_fixedAddr for the state machine and returns false
+// if there is nothing to send.
+bool TM1637Display32::prepareFrame(const uint8_t digits[], uint8_t digitsSet, uint8_t brightness) {
+  uint8_t dirty = dirtyDigits(digits, digitsSet);
+  bool sendBrightness = (brightness != m_chipBrightness);
+  m_inflight = sendBrightness ? TM1637_INFLIGHT_COMM3 : 0;
+  m_chipBrightness = brightness;
+  if (dirty == 0) return sendBrightness;  // COMM3-only transaction (or nothing)
+
+  uint8_t first = 0, last = 0, count = 0;
+  for (uint8_t digit = 0; digit < TM1637_MAX_DIGITS; digit++) {
+    if (!(dirty & (1 << digit))) continue;
+    if (count == 0) first = digit;
+    last = digit;
+    count++;
+    m_segments[digit] = digits[digit];
+  }
+
+  // Auto-increment sends START + address + every byte in [first, last] + STOP,
+  // fixed-address mode repeats START + address + byte + STOP per dirty digit.
+  // A byte is 28 state machine steps, START 3 and STOP 4.
+  uint8_t span = last - first + 1;
+  m_fixedAddr = (count * 63) < (35 + span * 28);
+  m_pos = first;
+  m_length = span;
+  if (!m_fixedAddr) dirty = ((1 << span) - 1) << first;  // Clean digits in the span go too
+
+  m_inflight |= dirty;
+  m_segmentsValid |= dirty;  // Optimistic: undone if this frame gets aborted
+  return true;
+}
+
+// Set up the first phase of the transaction chosen by prepareFrame()
+void TM1637Display32::startFrame() {
+  m_bit_count = 0;
+  #if TM1637_KEYS
+  if (m_keyScanning) {
+    m_phase = 12;
+    m_byte = TM1637_READ_KEYS;
+  } else
+  #endif
+  if (m_inflight & ~TM1637_INFLIGHT_COMM3) {
+    m_phase = 0;
+    m_byte = dataCommand();
+  } else {
+    m_phase = 7;  // Brightness only: straight to the display control command
+    m_byte = TM1637_I2C_COMM3 + (m_chipBrightness & 0x0f);
+  }
+}
+
+// Roll back the optimistic chip mirror for a frame that did not finish
+void TM1637Display32::abortFrame() {
+  #if TM1637_WAVE_CACHE
+  m_waveCodes = NULL;  // Recovery runs on the live state machine
+  #endif
+  m_segmentsValid &= ~m_inflight;
+  if (m_inflight & TM1637_INFLIGHT_COMM3) m_chipBrightness = 0xFF;
+}
+
+#if TM1637_RETRIES
+void TM1637Display32::busError() {
+  abortFrame();
+  #if TM1637_KEYS
+  if (m_keyScanning) {
+    m_keyScanning = false;  // Unanswered key scan: skip it, the next one is due soon
+  } else
+  #endif
+  if (m_retriesLeft > 0) {
+    TM1637_STAT(m_stats.framesAborted++);
+    m_retriesLeft--;
+    m_posted = true;  // Relaunch the newest frame once the bus is reset
+  } else {
+    TM1637_STAT(m_stats.framesAborted++);
+    m_error = TM1637_ERR_NOACK;
+    m_retriesLeft = m_retries;
+    #if TM1637_STATS
+    m_statsInFlight = false;  // Given up: not a completed frame
+    #endif
+  }
+  m_phase = 10;  // Recovery STOP and idle gap, then idle
+  m_counter = 0;
+}
+#endif
+
+void TM1637Display32::invalidate() {
+  // Applied by whoever starts the next frame, so the chip mirror has one owner.
+  // Racing calls may bump it once between them, which still asks for a resend.
+  m_resendRequests++;
+  TM1637_FENCE();
+  m_posted = true;
+  kick();
+  notifyPost();
+}
+
+#if TM1637_HOOKS
+void TM1637Display32::onPost(TM1637PostHook hook, void* ctx) {
+  m_postHook = NULL;
+  TM1637_FENCE();
+  m_postHookCtx = ctx;
+  TM1637_FENCE();
+  m_postHook = hook;
+}
+#endif
+
+void TM1637Display32::notifyPost() {
+  #if TM1637_HOOKS
+  TM1637PostHook hook = m_postHook;
+  if (hook) hook(m_postHookCtx);
+  #endif
+}
+
+void TM1637Display32::sendBrightness() {
+  setSegments(NULL, 0, 0);  // No new digits: sends COMM3 only, if it changed
+}
+
+bool TM1637Display32::update() {
+  #if TM1637_STATS
+  uint32_t start = TM1637_CYCLES();
+  bool idle = tick();
+  uint32_t cycles = TM1637_CYCLES() - start;
+
+  m_statsSeq++;
+  TM1637_FENCE();
+  if (m_statsReset) {
+    statsClear();
+    m_statsReset = false;
+  }
+  m_stats.updateCalls++;
+  m_statsCycles += cycles;
+  if (cycles < m_stats.updateCyclesMin) m_stats.updateCyclesMin = cycles;
+  if (cycles > m_stats.updateCyclesMax) m_stats.updateCyclesMax = cycles;
+  // PIO/RMT frames end in hardware; aborts either relaunch at once or clear
+  // m_statsInFlight, so this one made it
+  if (m_statsInFlight && !busy()) statsFrameDone();
+  TM1637_FENCE();
+  m_statsSeq++;
+  return idle;
+  #else
+  return tick();
+  #endif
+}
+
+#if TM1637_WATCHDOG
+// The transaction ran past the timeout: abort it, reset the bus, and resend
+// from the same retry budget as a missing ACK
+void TM1637Display32::watchdogExpired() {
+  abortFrame();  // Chip state unknown, resend once the bus is reset
+  TM1637_STAT(m_stats.framesTimedOut++);
+  #if TM1637_KEYS
+  if (m_keyScanning) {
+    m_keyScanning = false;  // Skip the scan, the next one is due soon
+  } else
+  #endif
+  #if TM1637_RETRIES
+  if (m_retriesLeft > 0) {
+    m_retriesLeft--;
+    m_posted = true;
+  } else
+  #endif
+  {
+    m_error = TM1637_ERR_TIMEOUT;  // A stuck bus: stop resending until the next post
+    #if TM1637_RETRIES
+    m_retriesLeft = m_retries;
+    #endif
+    #if TM1637_STATS
+    m_statsInFlight = false;  // Given up: not a completed frame
+    #endif
+  }
+  m_phase = 10;  // Recovery STOP and idle gap, then idle
+  m_counter = 0;
+  m_transmissionStartMillis = millis();
+  #if TM1637_PACING
+  m_frameTicks = 0;
+  #endif
+}
+#endif
+
+bool TM1637Display32::tick() {
+  // Frame boundary: pick up the newest posted frame, if any
+  if (!busy()) {
+    #if TM1637_HAS_PIO
+    if (m_pioFrame && tryClaim()) {
+      pioCount();
+      releaseClaim();
+    }
+    #endif
+    #if TM1637_SCROLL
+    animate();  // May post and start the next animation frame
+    #endif
+    #if TM1637_EFFECTS
+    brightnessEffects();
+    #endif
+    #if TM1637_KEYS
+    keyScan();  // Goes ahead of posted frames, so steady posting cannot starve it
+    #endif
+    if (!m_posted) return !busy();  // No transmission in progress
+    kick();
+    return isIdle();
+  }
+
+  #if TM1637_HAS_PIO
+  if (m_pioActive) return false;  // PIO runs the waveform by itself
+  #endif
+  #if TM1637_HAS_RMT
+  if (m_rmtActive) return false;  // RMT plays the waveform by itself
+  #endif
+
+  // Watchdog: if transmission takes too long, reset to idle
+  // When driven by ISR at 10kHz, a transmission takes ~20ms.
+  // When polled from loop(), it can take 50-150ms depending on loop load.
+  // Allow 500ms as generous timeout to avoid aborting valid transmissions.
+  #if TM1637_PACING
+  if (m_tickUs) {
+    // Tick-counted: no clock reads on the way to a step
+    #if TM1637_WATCHDOG
+    if (m_watchdogTicks && ++m_frameTicks > m_watchdogTicks) {
+      watchdogExpired();
+      return false;
+    }
+    #endif
+    if (m_paceCount > 1) {
+      m_paceCount--;
+      TM1637_STAT(m_stats.updateRateLimited++);
+      return false;
+    }
+    m_paceCount = m_paceTicks;
+  } else
+  #endif
+  if (!stepDue()) {
+    return false;
+  }
+
+  bool done;
+  #if TM1637_PACING
+  uint8_t steps = m_stepsPerTick;
+  #else
+  uint8_t steps = 1;
+  #endif
+  for (;;) {
+    #if TM1637_WAVE_CACHE
+    if (m_waveCodes != NULL) {
+      // Cached frame: one 2-bit code per step, no protocol state to walk
+      uint8_t code = (m_waveCodes[m_waveStep >> 2] >> ((m_waveStep & 3) * 2)) & 3;
+      if (code == 3) {
+        #if TM1637_RETRIES
+        if (dioHigh()) {
+          m_nacks++;
+          if (m_ackCheck) {
+            busError();
+            return false;
+          }
+        }
+        #endif
+        code = TM1637_LINE_CLK;
+      }
+      m_lines ^= code;
+      writeLines();
+      done = (++m_waveStep == m_waveSteps);
+      if (done) {
+        m_waveCodes = NULL;
+        m_counter = 255;  // Mark as complete
+      }
+      TM1637_STAT(m_stats.updateSteps++);
+      #if TM1637_TRACE
+      traceStep(15, (uint8_t)m_waveStep);
+      #endif
+      if (done || --steps == 0) break;
+      #if TM1637_PACING
+      if (m_stepSpinUs) delayMicroseconds(m_stepSpinUs);
+      #endif
+      continue;
+    }
+    #endif
+
+    // Sub-step 5 only exists in writeBit(): CLK is about to rise for the ACK
+    // clock and the chip should be holding DIO LOW by now. Sampled here rather
+    // than in step(), which the RMT transport replays to render waveforms.
+    #if TM1637_RETRIES
+    if (m_counter == 5 && dioHigh()) {
+      m_nacks++;
+      if (m_ackCheck) {
+        busError();
+        return false;
+      }
+    }
+    #endif
+    #if TM1637_KEYS
+    // Key data: the chip shifts a bit out after each CLK fall, read it with CLK HIGH
+    if (m_phase == 13 && m_counter == 2 && dioHigh()) m_keyByte |= 1 << m_bit_count;
+    #endif
+
+    #if TM1637_TRACE
+    uint8_t phase = m_phase;
+    uint8_t counter = m_counter;
+    #endif
+    done = step();
+    writeLines();
+    TM1637_STAT(m_stats.updateSteps++);
+    #if TM1637_TRACE
+    traceStep(phase, counter);
+    #endif
+
+    // Phase 11 waits out wall-clock time, more steps would only spin
+    if (done || m_phase == 11 || --steps == 0) break;
+    #if TM1637_PACING
+    if (m_stepSpinUs) delayMicroseconds(m_stepSpinUs);
+    #endif
+  }
+  return done && stepsDone();
+}
+
+bool TM1637Display32::stepDue() {
+  #if TM1637_WATCHDOG
+  if (m_timeoutMs && (uint32_t)(millis() - m_transmissionStartMillis) > m_timeoutMs) {
+    watchdogExpired();
+    return false;
+  }
+  #endif
+
+  // Rate limiting: ensure minimum time between state changes
+  if (m_bitDelayUs > 0) {
+    uint32_t now = micros();
+    if ((now - m_lastUpdateMicros) < m_bitDelayUs) {
+      TM1637_STAT(m_stats.updateRateLimited++);
+      return false;  // Not enough time elapsed, try again later
+    }
+    m_lastUpdateMicros = now;
+  }
+  return true;
+}
+
+// The step just taken ended a transaction; true once the bus is idle
+bool TM1637Display32::stepsDone() {
+  if (m_phase != 11 && m_phase != 14) {
+    m_error = TM1637_ERR_NONE;  // Display frame through (11 ends a bus reset, 14 a key scan)
+    #if TM1637_RETRIES
+    m_retriesLeft = m_retries;
+    #endif
+    m_framesDone++;
+    #if TM1637_STATS
+    // Counted here, as a newer post may launch the next frame before update() looks
+    if (m_statsInFlight) TM1637_STAT(statsFrameDone());
+    #endif
+  }
+  if (m_posted) {
+    kick();  // Newer frame was posted meanwhile: chain it straight on
+    return isIdle();
+  }
+  return true;
+}
+
+// Advance the protocol by one sub-step, updating m_lines.
+// Returns true when the final stop condition has been generated.
+bool TM1637Display32::step() {
+  // State machine for TM1637 protocol
+  // Protocol: START -> COMM1 -> STOP -> START -> COMM2+addr -> DATA bytes -> STOP -> START -> COMM3 -> STOP
+  // Phase 9 (START) runs before phase 0. Phases 10-11 reset the bus after a
+  // frame was cut off: recovery STOP (10) and >1ms idle gap (11), then idle.
+  // Phases 12-14 read the keys; phase 15 (a cached waveform) is replayed by tick().
+
+  switch (m_phase) {
+    case 0:  // Write COMM1 byte (0x40 = write data, 0x44 = fixed address)
+      if (writeBit()) {
+        m_phase = 1;
+        m_counter = 0;
+      }
+      break;
+
+    case 1:  // Stop condition after COMM1
+      if (stopCondition()) {
+        m_phase = 2;
+        m_counter = 0;
+        m_byte = TM1637_I2C_COMM2 + (m_pos & 0x07);  // Address command
+      }
+      break;
+
+    case 2:  // Start condition before COMM2
+      if (startCondition()) {
+        m_phase = 3;
+        m_counter = 0;
+      }
+      break;
+
+    case 3:  // Write COMM2 byte (address)
+      if (writeBit()) {
+        m_phase = 4;
+        m_counter = 0;
+        m_currentSegment = m_pos;
+        m_byte = m_segments[m_pos];
+      }
+      break;
+
+    case 4:  // Write segment data bytes (one byte per address in fixed mode)
+      if (writeBit()) {
+        m_currentSegment++;
+        if (m_fixedAddr || m_currentSegment >= m_pos + m_length) {
+          m_phase = 5;
+          m_counter = 0;
+        } else {
+          m_byte = m_segments[m_currentSegment];
+          m_counter = 0;
+        }
+      }
+      break;
+
+    case 5:  // Stop condition after data
+      if (stopCondition()) {
+        m_counter = 0;
+        if (m_fixedAddr) {
+          // Fixed address mode: next dirty digit gets its own address command
+          while (++m_pos < TM1637_MAX_DIGITS && !(m_inflight & (1 << m_pos))) {}
+          if (m_pos < TM1637_MAX_DIGITS) {
+            m_phase = 2;
+            m_byte = TM1637_I2C_COMM2 + m_pos;
+            break;
+          }
+        }
+        if (!(m_inflight & TM1637_INFLIGHT_COMM3)) {
+          m_counter = 255;  // Brightness unchanged: no display control block
+          return true;
+        }
+        m_phase = 6;
+        m_byte = TM1637_I2C_COMM3 + (m_chipBrightness & 0x0f);  // Display control
+      }
+      break;
+
+    case 6:  // Start condition before COMM3
+      if (startCondition()) {
+        m_phase = 7;
+        m_counter = 0;
+      }
+      break;
+
+    case 7:  // Write COMM3 byte (display control)
+      if (writeBit()) {
+        m_phase = 8;
+        m_counter = 0;
+      }
+      break;
+
+    case 8:  // Final stop condition
+      if (stopCondition()) {
+        m_counter = 255;  // Mark as complete
+        return true;
+      }
+      break;
+
+    case 9:  // Start condition for a new frame (both lines released first)
+      if (startCondition()) {
+        startFrame();  // Phase 0, or 7 for a brightness-only frame
+        m_counter = 0;
+      }
+      break;
+
+    #if TM1637_RETRIES || TM1637_WATCHDOG
+    case 10:  // Recovery stop after an aborted frame: CLK LOW -> DIO LOW -> CLK HIGH -> DIO HIGH
+      if (stopCondition()) {
+        m_phase = 11;
+        m_counter = 0;
+        #if TM1637_PACING
+        if (m_tickUs) m_gapCount = 0;
+        else
+        #endif
+        m_gapStartMicros = micros();
+      }
+      break;
+    #endif
+
+    #if TM1637_KEYS
+    case 12:  // Write the read-keys command
+      if (writeBit()) {
+        m_phase = 13;
+        m_counter = 0;
+        m_keyByte = 0;
+      }
+      break;
+
+    case 13:  // Clock in the key scan byte
+      if (readBit()) {
+        m_phase = 14;
+        m_counter = 0;
+      }
+      break;
+
+    case 14:  // Stop condition after key data
+      if (stopCondition()) {
+        m_counter = 255;
+        m_keyScanning = false;
+        keyScanned(m_keyByte);
+        return true;
+      }
+      break;
+
+    #endif
+    #if TM1637_RETRIES || TM1637_WATCHDOG
+    case 11:  // Datasheet: reset both lines high for >1ms after error
+      #if TM1637_PACING
+      if (m_tickUs ? ++m_gapCount >= m_gapSteps : (uint32_t)(micros() - m_gapStartMicros) >= 1200) {
+      #else
+      if ((uint32_t)(micros() - m_gapStartMicros) >= 1200) {
+      #endif
+        m_counter = 255;  // Bus reset; the aborted frame gets re-posted
+        return true;
+      }
+      break;
+    #endif
+  }
+
+  return false;
+}
+
+// Drive the pins to match m_lines (only the line that changed is touched)
+void TM1637Display32::writeLines() {
+  uint8_t changed = m_lines ^ m_linesOut;
+  if (changed & TM1637_LINE_CLK) {
+    if (m_lines & TM1637_LINE_CLK) lineRelease(TM1637_CLK);
+    else lineLow(TM1637_CLK);
+  }
+  if (changed & TM1637_LINE_DIO) {
+    if (m_lines & TM1637_LINE_DIO) lineRelease(TM1637_DIO);
+    else lineLow(TM1637_DIO);
+  }
+  m_linesOut = m_lines;
+}
+
+bool TM1637Display32::isIdle() const {
+  return !busy() && !m_posted;
+}
+
+bool TM1637Display32::pump(unsigned long timeout_us) {
+  unsigned long start = micros();
+  while ((micros() - start) < timeout_us) {
+    if (update()) return true;  // idle or complete
+    pumpPace();
+  }
+  return false;  // timed out, transmission still in progress
+}
+
+void TM1637Display32::pumpPace() const {
+  #if TM1637_PACING
+  if (m_tickUs) delayMicroseconds(m_tickUs);  // Keep to the declared tick
+  #endif
+}
+
+unsigned long TM1637Display32::nowMicros() {
+  return micros();
+}
+
+// Time to the next animation frame, fade/blink step or key scan
+uint32_t TM1637Display32::idleWait() const {
+  uint32_t wait = TM1637_NOTHING_DUE;
+  #if TM1637_SCROLL
+  if (m_animSource != ANIM_NONE) {
+    uint32_t elapsed = micros() - m_animStart;
+    wait = (elapsed < m_animDurationUs) ? m_animDurationUs - elapsed : 0;
+  }
+  #endif
+  #if TM1637_EFFECTS
+  if (m_fading) {
+    uint32_t elapsed = micros() - m_fadeStart;
+    uint32_t fadeWait = (elapsed < m_fadeIntervalUs) ? m_fadeIntervalUs - elapsed : 0;
+    if (fadeWait < wait) wait = fadeWait;
+  }
+  if (m_blinking) {
+    uint32_t half = m_blinkOff ? m_blinkOffUs : m_blinkOnUs;
+    uint32_t elapsed = micros() - m_blinkStart;
+    uint32_t blinkWait = (elapsed < half) ? half - elapsed : 0;
+    if (blinkWait < wait) wait = blinkWait;
+  }
+  #endif
+  #if TM1637_KEYS
+  if (m_keyIntervalMs) {
+    uint32_t elapsed = millis() - m_keyLastScan;
+    uint32_t keyWait = (elapsed < m_keyIntervalMs) ? (m_keyIntervalMs - elapsed) * 1000UL : 0;
+    if (keyWait < wait) wait = keyWait;
+  }
+  #endif
+  return wait;
+}
+
+uint32_t TM1637Display32::timeUntilNextStep() const {
+  if (busy()) {
+    #if TM1637_HAS_PIO
+    if (m_pioActive) return 1000;  // The hardware finishes the frame by itself
+    #endif
+    #if TM1637_HAS_RMT
+    if (m_rmtActive) return 1000;
+    #endif
+    #if TM1637_PACING
+    if (m_tickUs) return m_tickUs;  // Counted: one call per declared tick
+    #endif
+    uint32_t elapsed;
+    #if TM1637_RETRIES || TM1637_WATCHDOG
+    if (m_phase == 11) {
+      elapsed = micros() - m_gapStartMicros;
+      return (elapsed < 1200) ? 1200 - elapsed : 0;
+    }
+    #endif
+    if (m_bitDelayUs == 0) return 0;
+    elapsed = micros() - m_lastUpdateMicros;
+    return (elapsed < m_bitDelayUs) ? m_bitDelayUs - elapsed : 0;
+  }
+  if (m_posted) return 0;
+
+  uint32_t wait = idleWait();
+  #if TM1637_THROTTLE
+  if (m_minIntervalMillis) {
+    // isReadyForUpdate() turns true then: wake the caller to post
+    uint32_t elapsed = millis() - m_lastTransmissionMillis;
+    if (elapsed < m_minIntervalMillis) {
+      uint32_t readyWait = (m_minIntervalMillis - elapsed) * 1000UL;
+      if (readyWait < wait) wait = readyWait;
+    }
+  }
+  #endif
+  return wait;
+}
+
+uint32_t TM1637Display32::service() {
+  while (!update()) {
+    uint32_t wait = timeUntilNextStep();
+    if (wait != 0) return wait;
+  }
+  return timeUntilNextStep();
+}
+
+void TM1637Display32::setBitDelay(uint16_t us) {
+  m_bitDelayUs = us;
+  #if TM1637_PACING
+  tickTiming();
+  #endif
+}
+
+#if TM1637_WATCHDOG
+void TM1637Display32::setTimeout(uint16_t ms) {
+  m_timeoutMs = ms;
+  #if TM1637_PACING
+  tickTiming();
+  #endif
+}
+#endif
+
+#if TM1637_PACING
+void TM1637Display32::setTickPeriod(uint16_t tick_us) {
+  m_tickUs = tick_us;
+  tickTiming();
+}
+
+// Convert the delays to update() calls once, so tick() only counts
+void TM1637Display32::tickTiming() {
+  if (m_tickUs == 0) return;
+  m_paceTicks = (m_bitDelayUs + m_tickUs - 1) / m_tickUs;
+  if (m_paceTicks == 0) m_paceTicks = 1;
+  uint32_t stepUs = (uint32_t)m_tickUs * m_paceTicks;
+  m_gapSteps = (uint16_t)((1200 + stepUs - 1) / stepUs);  // >1ms reset gap
+  #if TM1637_WATCHDOG
+  m_watchdogTicks = ((uint32_t)m_timeoutMs * 1000 + m_tickUs - 1) / m_tickUs;
+  #endif
+  m_paceCount = 0;
+}
+#endif
+
+uint16_t TM1637Display32::getBitDelay() const {
+  return m_bitDelayUs;
+}
+
+#if TM1637_PACING
+void TM1637Display32::setStepsPerTick(uint8_t steps, uint8_t spin_us) {
+  m_stepsPerTick = steps ? steps : 1;
+  m_stepSpinUs = spin_us;
+}
+
+uint8_t TM1637Display32::getStepsPerTick() const {
+  return m_stepsPerTick;
+}
+#endif
+
+#if TM1637_RETRIES
+uint16_t TM1637Display32::calibrateBitDelay(uint16_t min_us) {
+  #if TM1637_HAS_PIO
+  if (m_pioActive) return m_bitDelayUs;  // PIO timing is set by beginPIO()
+  #endif
+  #if TM1637_HAS_RMT
+  if (m_rmtActive) return m_bitDelayUs;  // RMT timing is set by beginRMT()
+  #endif
+
+  uint16_t original = m_bitDelayUs;
+  #if TM1637_PACING
+  uint8_t stepsPerTick = m_stepsPerTick;
+  m_stepsPerTick = 1;  // The delay under test spaces every step
+  uint16_t tickUs = m_tickUs;
+  m_tickUs = 0;  // Paced by the clock, at 1us resolution
+  #endif
+  uint8_t retries = m_retries;
+  m_retries = 0;
+  m_retriesLeft = 0;  // A missing ACK ends the test frame, no retries
+  uint16_t fastest = original;
+  bool found = false;  // Some delay ACKed every byte
+  if (m_digitsSet == 0) clear();  // Make sure a test frame has data bytes
+
+  // Start at the current delay. If the module misses bytes there, double it
+  // until it keeps up; then go down by a quarter each round
+  uint16_t candidate = original;
+  for (;;) {
+    m_bitDelayUs = candidate;
+    unsigned long timeout_us = 300UL * candidate + 5000;  // ~220 steps per frame
+    bool reliable = true;
+    for (uint8_t frame = 0; frame < 3 && reliable; frame++) {
+      pump(timeout_us);  // Let anything pending finish at this rate
+      m_nacks = 0;
+      invalidate();  // Full frame: every byte gets an ACK check
+      reliable = pump(timeout_us) && m_nacks == 0;
+    }
+    if (reliable) {
+      fastest = candidate;
+      found = true;
+      if (candidate <= min_us) break;
+      uint16_t next = candidate - (candidate + 3) / 4;
+      candidate = next < min_us ? min_us : next;
+    } else {
+      if (found || candidate >= TM1637_CALIBRATE_MAX_US) break;
+      candidate = candidate == 0 ? 1 : candidate * 2;
+      if (candidate > TM1637_CALIBRATE_MAX_US) candidate = TM1637_CALIBRATE_MAX_US;
+    }
+  }
+
+  if (found) {
+    m_bitDelayUs = fastest + (fastest + 1) / 2;  // 50% margin; a clean 0us stays 0
+  } else {
+    m_bitDelayUs = original;  // No ACK even at the slowest rate: not calibrated
+  }
+  m_retries = retries;
+  m_retriesLeft = retries;
+  #if TM1637_PACING
+  m_stepsPerTick = stepsPerTick;
+  m_tickUs = tickUs;
+  tickTiming();
+  #endif
+  invalidate();  // Repaint whatever a failed test frame left behind
+  pump(300UL * m_bitDelayUs + 5000);
+  return m_bitDelayUs;
+}
+#endif
+
+#if TM1637_STATS
+// A frame reached its final STOP: count it with its post-to-STOP latency.
+// Caller brackets with m_statsSeq
+void TM1637Display32::statsFrameDone() {
+  uint32_t latency = micros() - m_frameMicros;
+  m_statsInFlight = false;
+  m_stats.framesCompleted++;
+  m_statsLatencyFrames++;
+  m_statsLatencyUs += latency;
+  if (latency < m_stats.latencyUsMin) m_stats.latencyUsMin = latency;
+  if (latency > m_stats.latencyUsMax) m_stats.latencyUsMax = latency;
+}
+
+void TM1637Display32::statsClear() {
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_stats.updateCyclesMin = 0xFFFFFFFF;
+  m_stats.latencyUsMin = 0xFFFFFFFF;
+  m_statsCycles = 0;
+  m_statsLatencyFrames = 0;
+  m_statsLatencyUs = 0;
+}
+
+void TM1637Display32::getStats(TM1637Stats& stats) const {
+  uint64_t cycles;
+  uint64_t latency;
+  uint32_t latencyFrames;
+  uint32_t seq;
+  do {
+    seq = m_statsSeq;
+    TM1637_FENCE();
+    stats = m_stats;
+    cycles = m_statsCycles;
+    latency = m_statsLatencyUs;
+    latencyFrames = m_statsLatencyFrames;
+    TM1637_FENCE();
+  } while ((seq & 1) || seq != m_statsSeq);  // Retry if update() wrote meanwhile
+
+  if (stats.updateCalls == 0) stats.updateCyclesMin = 0;
+  if (latencyFrames == 0) stats.latencyUsMin = 0;
+  stats.updateCyclesAvg = stats.updateCalls ? (uint32_t)(cycles / stats.updateCalls) : 0;
+  stats.latencyUsAvg = latencyFrames ? (uint32_t)(latency / latencyFrames) : 0;
+}
+
+void TM1637Display32::resetStats() {
+  m_statsReset = true;
+}
+#endif
+
+#if TM1637_TRACE
+#if (TM1637_TRACE & (TM1637_TRACE - 1)) != 0
+#error "TM1637_TRACE must be a power of two"
+#endif
+
+void TM1637Display32::traceStep(uint8_t phase, uint8_t counter) {
+  if (m_traceFrozen) return;
+  unsigned long now = micros();
+  unsigned long delta = now - m_traceMicros;
+  m_traceMicros = now;
+
+  TM1637TraceEntry& entry = m_trace[m_traceHead];
+  entry.deltaUs = delta > 0xFFFF ? 0xFFFF : (uint16_t)delta;
+  entry.phase = phase;
+  entry.counter = counter;
+  entry.lines = m_linesOut;
+  m_traceHead = (m_traceHead + 1) & (TM1637_TRACE - 1);
+  if (m_traceCount < TM1637_TRACE) m_traceCount++;
+}
+
+void TM1637Display32::clearTrace() {
+  m_traceFrozen = true;
+  TM1637_FENCE();
+  m_traceCount = 0;
+  TM1637_FENCE();
+  m_traceFrozen = false;
+}
+
+void TM1637Display32::dumpTrace(Print& out, bool vcd) {
+  m_traceFrozen = true;
+  TM1637_FENCE();
+  uint16_t count = m_traceCount;
+  uint16_t index = (m_traceHead - count) & (TM1637_TRACE - 1);
+
+  if (vcd) {
+    out.println("$timescale 1us $end");
+    out.println("$scope module tm1637 $end");
+    out.println("$var wire 1 c CLK $end");
+    out.println("$var wire 1 d DIO $end");
+    out.println("$var reg 4 p phase $end");
+    out.println("$var reg 8 s counter $end");  // Phase 15 counts replayed steps
+    out.println("$upscope $end");
+    out.println("$enddefinitions $end");
+  } else {
+    out.println("t_us,phase,counter,clk,dio");
+  }
+
+  unsigned long t = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    const TM1637TraceEntry& entry = m_trace[index];
+    index = (index + 1) & (TM1637_TRACE - 1);
+    if (i > 0) t += entry.deltaUs;  // Entries before the first one are gone
+    uint8_t clk = entry.lines & TM1637_LINE_CLK ? 1 : 0;
+    uint8_t dio = entry.lines & TM1637_LINE_DIO ? 1 : 0;
+    if (vcd) {
+      out.print('#');
+      out.println(t);
+      out.print(clk);
+      out.println('c');
+      out.print(dio);
+      out.println('d');
+      out.print('b');
+      for (int8_t bit = 3; bit >= 0; bit--) out.print((entry.phase >> bit) & 1);
+      out.println(" p");
+      out.print('b');
+      for (int8_t bit = 7; bit >= 0; bit--) out.print((entry.counter >> bit) & 1);
+      out.println(" s");
+    } else {
+      out.print(t);
+      out.print(',');
+      out.print(entry.phase);
+      out.print(',');
+      out.print(entry.counter);
+      out.print(',');
+      out.print(clk);
+      out.print(',');
+      out.println(dio);
+    }
+  }
+
+  TM1637_FENCE();
+  m_traceFrozen = false;
+}
+#endif
+
+#if TM1637_RETRIES
+void TM1637Display32::setAckCheck(bool enable) {
+  m_ackCheck = enable;
+}
+
+void TM1637Display32::setRetries(uint8_t retries) {
+  m_retries = retries;
+  m_retriesLeft = retries;
+}
+#endif
+
+uint8_t TM1637Display32::getError() const {
+  return m_error;
+}
+
+uint16_t TM1637Display32::framesSent() const {
+  return m_framesDone;
+}
+
+#if TM1637_KEYS
+void TM1637Display32::setKeyScan(uint16_t interval_ms, uint8_t debounce) {
+  m_keyDebounce = debounce ? debounce : 1;
+  m_keyLastScan = millis() - interval_ms;  // First scan at the next chance
+  m_keyIntervalMs = interval_ms;
+  #if TM1637_HAS_TIMER
+  if (m_timerActive && isIdle()) timerIdle();
+  #endif
+}
+
+uint16_t TM1637Display32::getKeyScanInterval() const {
+  return m_keyIntervalMs;
+}
+
+uint8_t TM1637Display32::getKeys() const {
+  return m_key;
+}
+
+bool TM1637Display32::readKeyEvent(uint8_t& key, bool& pressed) {
+  uint8_t tail = m_keyTail;
+  if (tail == m_keyHead) return false;
+  TM1637_FENCE();
+  uint8_t event = m_keyEvents[tail];
+  TM1637_FENCE();
+  m_keyTail = (tail + 1) % TM1637_KEY_EVENTS;
+  key = event & 0x7F;
+  pressed = (event & 0x80) != 0;
+  return true;
+}
+
+// Start a key scan if one is due and the bus is free (idle path of tick())
+void TM1637Display32::keyScan() {
+  if (m_keyIntervalMs == 0) return;
+  #if TM1637_HAS_PIO
+  if (m_pioActive) return;  // The PIO program only writes
+  #endif
+  #if TM1637_HAS_RMT
+  if (m_rmtActive) return;  // RMT only plays waveforms out
+  #endif
+  uint32_t now = millis();
+  if ((now - m_keyLastScan) < m_keyIntervalMs) return;
+  if (!tryClaim()) return;  // A producer is starting a frame: scan next time
+  if (!busy()) {
+    m_keyLastScan = now;
+    m_keyScanning = true;
+    m_inflight = 0;  // No display content to roll back if the scan is cut off
+    #if TM1637_WATCHDOG
+    m_transmissionStartMillis = now;
+    #if TM1637_PACING
+    m_frameTicks = 0;
+    #endif
+    #endif
+    m_phase = 9;
+    m_counter = 0;  // Start transmission (must be last!)
+  }
+  releaseClaim();
+}
+
+// Debounce a scan result; 0xFF = no key, else K1 has bit 3 clear, K2 bit 4
+void TM1637Display32::keyScanned(uint8_t code) {
+  uint8_t key = TM1637_NO_KEY;
+  if (!(code & 0x08)) key = 7 - (code & 0x07);
+  else if (!(code & 0x10)) key = 15 - (code & 0x07);
+
+  if (key != m_keyCandidate) {
+    m_keyCandidate = key;
+    m_keyCount = 0;
+  }
+  if (m_keyCount < m_keyDebounce) m_keyCount++;
+  if (m_keyCount == m_keyDebounce && key != m_key) {
+    if (m_key != TM1637_NO_KEY) keyEvent(m_key);  // Release
+    if (key != TM1637_NO_KEY) keyEvent(key | 0x80);
+    m_key = key;
+  }
+}
+
+void TM1637Display32::keyEvent(uint8_t event) {
+  uint8_t head = m_keyHead;
+  uint8_t next = (head + 1) % TM1637_KEY_EVENTS;
+  if (next == m_keyTail) return;  // Full
+  m_keyEvents[head] = event;
+  TM1637_FENCE();
+  m_keyHead = next;
+}
+#endif
+
+#if TM1637_THROTTLE
+void TM1637Display32::setMinInterval(unsigned long interval_ms) {
+  m_minIntervalMillis = interval_ms;
+}
+
+bool TM1637Display32::isReadyForUpdate() {
+  if (!isIdle()) return false;
+  if (m_minIntervalMillis == 0) return true;
+  return (uint32_t)(millis() - m_lastTransmissionMillis) >= m_minIntervalMillis;
+}
+#endif
+
+// Write one bit of m_byte, returns true when byte complete (including ACK)
+bool TM1637Display32::writeBit() {
+  switch (m_counter) {
+    case 0:  // CLK LOW
+      m_lines &= ~TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 1:  // Set DIO to data bit
+      if (m_byte & 0x01) {
+        m_lines |= TM1637_LINE_DIO;
+      } else {
+        m_lines &= ~TM1637_LINE_DIO;
+      }
+      m_counter++;
+      break;
+
+    case 2:  // CLK HIGH (data is sampled by TM1637)
+      m_lines |= TM1637_LINE_CLK;
+      m_byte >>= 1;
+      m_bit_count++;
+      if (m_bit_count < 8) {
+        m_counter = 0;  // Loop back for next bit
+      } else {
+        m_counter++;  // Move to ACK phase
+      }
+      break;
+
+    case 3:  // CLK LOW for ACK
+      m_lines &= ~TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 4:  // Release DIO for ACK (update() samples it before the next sub-step)
+      m_lines |= TM1637_LINE_DIO;
+      m_counter++;
+      break;
+
+    case 5:  // CLK HIGH for ACK
+      m_lines |= TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 6:  // CLK LOW after ACK
+      m_lines &= ~TM1637_LINE_CLK;
+      m_bit_count = 0;
+      return true;  // Byte complete
+  }
+  return false;
+}
+
+#if TM1637_KEYS
+// Read one bit into m_keyByte (tick() samples DIO before sub-step 2),
+// returns true when the byte and its ACK clock are done
+bool TM1637Display32::readBit() {
+  switch (m_counter) {
+    case 0:  // CLK LOW, DIO released: the chip drives it
+      m_lines &= ~TM1637_LINE_CLK;
+      m_lines |= TM1637_LINE_DIO;
+      m_counter++;
+      break;
+
+    case 1:  // CLK HIGH
+      m_lines |= TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 2:  // Bit sampled: CLK LOW for the next one, or for the ACK clock
+      m_lines &= ~TM1637_LINE_CLK;
+      m_bit_count++;
+      m_counter = (m_bit_count < 8) ? 1 : 3;
+      break;
+
+    case 3:  // CLK HIGH for ACK
+      m_lines |= TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 4:  // CLK LOW after ACK
+      m_lines &= ~TM1637_LINE_CLK;
+      m_bit_count = 0;
+      return true;
+  }
+  return false;
+}
+#endif
+
+// Generate start condition, returns true when complete
+bool TM1637Display32::startCondition() {
+  switch (m_counter) {
+    case 0:  // Ensure CLK is HIGH
+      m_lines |= TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 1:  // Ensure DIO is HIGH
+      m_lines |= TM1637_LINE_DIO;
+      m_counter++;
+      break;
+
+    case 2:  // DIO goes LOW while CLK is HIGH (start condition)
+      m_lines &= ~TM1637_LINE_DIO;
+      return true;
+  }
+  return false;
+}
+
+// Generate stop condition, returns true when complete
+bool TM1637Display32::stopCondition() {
+  switch (m_counter) {
+    case 0:  // CLK LOW
+      m_lines &= ~TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 1:  // DIO LOW
+      m_lines &= ~TM1637_LINE_DIO;
+      m_counter++;
+      break;
+
+    case 2:  // CLK HIGH
+      m_lines |= TM1637_LINE_CLK;
+      m_counter++;
+      break;
+
+    case 3:  // DIO HIGH (stop condition: DIO rises while CLK is HIGH)
+      m_lines |= TM1637_LINE_DIO;
+      return true;
+  }
+  return false;
+}
+
+#if TM1637_HAS_PIO
+bool TM1637Display32::beginPIO(PIO pio, uint16_t step_us) {
+  if (m_pioActive) return true;
+  if (!pio_can_add_program(pio, &tm1637_program)) return false;
+  int sm = pio_claim_unused_sm(pio, false);
+  if (sm < 0) return false;
+
+  // Never hand the pins over mid-transmission
+  while (m_counter != 255) update();
+
+  m_pio = pio;
+  m_pioSm = (uint)sm;
+  m_pioOffset = pio_add_program(pio, &tm1637_program);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, m_pioOffset, m_pioOffset + TM1637_PIO_WRAP);
+  sm_config_set_sideset(&c, 2, true, true);  // 1 bit + opt enable, drives pindirs
+  sm_config_set_sideset_pins(&c, m_pinClk);
+  sm_config_set_out_pins(&c, m_pinDIO, 1);
+  sm_config_set_set_pins(&c, m_pinDIO, 1);
+  sm_config_set_out_shift(&c, true, false, 32);  // LSB first, manual pull
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);  // 8 words: a full frame fits
+  sm_config_set_clkdiv(&c, (float)clock_get_hz(clk_sys) * step_us /
+                           (1000000.0f * TM1637_PIO_CYCLES_PER_STEP));
+
+  // Open-drain: output latch stays LOW, pindirs select drive-low vs. released
+  uint32_t mask = (1u << m_pinClk) | (1u << m_pinDIO);
+  pio_sm_set_pins_with_mask(pio, m_pioSm, 0, mask);
+  pio_sm_set_pindirs_with_mask(pio, m_pioSm, 0, mask);
+  pio_gpio_init(pio, m_pinClk);
+  pio_gpio_init(pio, m_pinDIO);
+  gpio_pull_up(m_pinClk);
+  gpio_pull_up(m_pinDIO);
+
+  pio_sm_init(pio, m_pioSm, m_pioOffset, &c);
+  pio_sm_set_enabled(pio, m_pioSm, true);
+  m_pioActive = true;
+  return true;
+}
+
+bool TM1637Display32::pioIdle() const {
+  return pio_sm_is_tx_fifo_empty(m_pio, m_pioSm) &&
+         pio_sm_get_pc(m_pio, m_pioSm) == m_pioOffset;
+}
+
+// A frame counts once the state machine has played it out, as a bit-banged
+// one does at its last step, not when it is queued
+void TM1637Display32::pioCount() {
+  if (m_pioFrame && pioIdle()) {
+    m_pioFrame = false;
+    m_framesDone++;
+  }
+}
+
+void TM1637Display32::pioWriteFrame() {
+  // A 6-digit burst is 1 + 2 + 1 = 4 words; fixed address mode is only
+  // chosen for up to 3 scattered digits (1 + 3 + 1), so the 8-deep FIFO
+  // never blocks
+  if (!(m_inflight & ~TM1637_INFLIGHT_COMM3)) {
+    // Brightness only
+  } else if (m_fixedAddr) {
+    pioPutBlock(m_pio, m_pioSm, dataCommand(), NULL, 0);
+    for (uint8_t digit = 0; digit < TM1637_MAX_DIGITS; digit++) {
+      if (!(m_inflight & (1 << digit))) continue;
+      pioPutBlock(m_pio, m_pioSm, TM1637_I2C_COMM2 + digit, &m_segments[digit], 1);
+    }
+  } else {
+    pioPutBlock(m_pio, m_pioSm, dataCommand(), NULL, 0);
+    pioPutBlock(m_pio, m_pioSm, TM1637_I2C_COMM2 + m_pos, &m_segments[m_pos], m_length);
+  }
+  if (m_inflight & TM1637_INFLIGHT_COMM3) {
+    pioPutBlock(m_pio, m_pioSm, TM1637_I2C_COMM3 + (m_chipBrightness & 0x0f), NULL, 0);
+  }
+}
+#endif
+
+#if TM1637_HAS_RMT
+bool TM1637Display32::beginRMT(uint16_t step_us) {
+  if (m_rmtActive) return true;
+
+  // Never hand the pins over mid-transmission
+  while (m_counter != 255) update();
+
+  m_rmtClk = NULL;
+  m_rmtDIO = NULL;
+  m_rmtEncoderClk = NULL;
+  m_rmtEncoderDIO = NULL;
+  m_rmtSync = NULL;
+  m_rmtSymbols = (rmt_symbol_word_t*)malloc(2 * TM1637_RMT_SYMBOLS * sizeof(rmt_symbol_word_t));
+  if (m_rmtSymbols == NULL) return false;
+
+  rmt_tx_channel_config_t config;
+  memset(&config, 0, sizeof(config));
+  config.clk_src = RMT_CLK_SRC_DEFAULT;
+  config.resolution_hz = 1000000;  // 1 tick = 1us
+  config.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+  config.trans_queue_depth = 1;
+  config.flags.io_od_mode = 1;  // Open-drain: level 1 releases the line to the pull-up
+
+  rmt_copy_encoder_config_t encoderConfig;
+  memset(&encoderConfig, 0, sizeof(encoderConfig));
+
+  rmt_tx_event_callbacks_t callbacks;
+  memset(&callbacks, 0, sizeof(callbacks));
+  callbacks.on_trans_done = rmtDone;
+
+  config.gpio_num = (gpio_num_t)m_pinClk;
+  bool ok = rmt_new_tx_channel(&config, &m_rmtClk) == ESP_OK;
+  config.gpio_num = (gpio_num_t)m_pinDIO;
+  ok = ok && rmt_new_tx_channel(&config, &m_rmtDIO) == ESP_OK;
+  ok = ok && rmt_new_copy_encoder(&encoderConfig, &m_rmtEncoderClk) == ESP_OK;
+  ok = ok && rmt_new_copy_encoder(&encoderConfig, &m_rmtEncoderDIO) == ESP_OK;
+  ok = ok && rmt_tx_register_event_callbacks(m_rmtClk, &callbacks, this) == ESP_OK;
+  ok = ok && rmt_tx_register_event_callbacks(m_rmtDIO, &callbacks, this) == ESP_OK;
+  ok = ok && rmt_enable(m_rmtClk) == ESP_OK;
+  ok = ok && rmt_enable(m_rmtDIO) == ESP_OK;
+  if (!ok) {
+    rmtRelease();
+    return false;
+  }
+
+  gpio_pullup_en((gpio_num_t)m_pinClk);
+  gpio_pullup_en((gpio_num_t)m_pinDIO);
+
+  // Start both channels on the same clock edge where the hardware supports it.
+  // Otherwise rmtWriteFrame() bounds the start skew in software.
+  rmt_channel_handle_t channels[2] = { m_rmtClk, m_rmtDIO };
+  rmt_sync_manager_config_t syncConfig;
+  memset(&syncConfig, 0, sizeof(syncConfig));
+  syncConfig.tx_channel_array = channels;
+  syncConfig.array_size = 2;
+  if (rmt_new_sync_manager(&syncConfig, &m_rmtSync) != ESP_OK) {
+    m_rmtSync = NULL;
+  }
+
+  m_rmtStepTicks = step_us;
+  m_rmtPending = 0;
+  m_rmtActive = true;
+  return true;
+}
+
+void TM1637Display32::rmtRelease() {
+  if (m_rmtSync) rmt_del_sync_manager(m_rmtSync);
+  if (m_rmtClk) {
+    rmt_disable(m_rmtClk);
+    rmt_del_channel(m_rmtClk);
+  }
+  if (m_rmtDIO) {
+    rmt_disable(m_rmtDIO);
+    rmt_del_channel(m_rmtDIO);
+  }
+  if (m_rmtEncoderClk) rmt_del_encoder(m_rmtEncoderClk);
+  if (m_rmtEncoderDIO) rmt_del_encoder(m_rmtEncoderDIO);
+  free(m_rmtSymbols);
+  m_rmtSymbols = NULL;
+}
+
+bool IRAM_ATTR TM1637Display32::rmtDone(rmt_channel_handle_t channel,
+                                        const rmt_tx_done_event_data_t* edata, void* ctx) {
+  TM1637Display32* display = (TM1637Display32*)ctx;
+  // The second channel through ends the frame; rmtAbort() zeroes the count
+  // without callbacks, so a frame cut off is never counted
+  if (display->m_rmtPending > 0 && --display->m_rmtPending == 0) display->m_framesDone++;
+  return false;  // No task woken
+}
+
+void TM1637Display32::rmtAbort() {
+  // Disabling a channel stops its transaction without a done callback
+  rmt_disable(m_rmtClk);
+  rmt_disable(m_rmtDIO);
+  rmt_enable(m_rmtClk);
+  rmt_enable(m_rmtDIO);
+  m_rmtPending = 0;
+}
+
+void TM1637Display32::rmtWriteFrame(bool reset) {
+  for (uint8_t attempt = 0; attempt < 3; attempt++) {
+    if (reset) rmtAbort();
+
+    RmtTrack clk = { m_rmtSymbols, 0, 1, 0 };
+    RmtTrack dio = { m_rmtSymbols + TM1637_RMT_SYMBOLS, 0, 1, 0 };
+    uint32_t ticks = m_rmtStepTicks;
+
+    if (reset) {
+      // Same forced stop as the bit-banged path: CLK LOW -> DIO LOW -> CLK HIGH -> DIO HIGH
+      rmtEmitLines(clk, dio, TM1637_LINE_DIO, ticks);
+      rmtEmitLines(clk, dio, 0, ticks);
+      rmtEmitLines(clk, dio, TM1637_LINE_CLK, ticks);
+      rmtEmitLines(clk, dio, TM1637_LINE_CLK | TM1637_LINE_DIO, 1200);  // >1ms reset
+    }
+    rmtEmitLines(clk, dio, TM1637_LINE_CLK | TM1637_LINE_DIO, ticks);
+
+    // Replay the update() state machine into the buffers instead of the pins
+    startFrame();
+    m_lines = TM1637_LINE_CLK;  // START: DIO LOW while CLK HIGH
+    m_counter = 0;
+    rmtEmitLines(clk, dio, m_lines, ticks);
+    bool done;
+    do {
+      done = step();
+      rmtEmitLines(clk, dio, m_lines, ticks);
+    } while (!done);
+    rmtFlush(clk);
+    rmtFlush(dio);
+
+    rmt_transmit_config_t txConfig;
+    memset(&txConfig, 0, sizeof(txConfig));
+    txConfig.flags.eot_level = 1;  // Leave both lines released afterwards
+
+    m_rmtPending = 2;
+    int64_t start = esp_timer_get_time();
+    if (m_rmtSync) rmt_sync_reset(m_rmtSync);
+    rmt_transmit(m_rmtClk, m_rmtEncoderClk, clk.symbols,
+                 ((clk.halves + 1) / 2) * sizeof(rmt_symbol_word_t), &txConfig);
+    rmt_transmit(m_rmtDIO, m_rmtEncoderDIO, dio.symbols,
+                 ((dio.halves + 1) / 2) * sizeof(rmt_symbol_word_t), &txConfig);
+
+    // Without hardware sync the DIO channel starts later than CLK. Each step
+    // changes only one line, so a skew under half a step keeps every edge in
+    // order; if we were preempted in between, reset the bus and try again.
+    if (m_rmtSync || (esp_timer_get_time() - start) < (int64_t)(ticks / 2)) return;
+    reset = true;
+  }
+}
+#endif
+
+#if TM1637_HAS_TIMER
+#if defined(ARDUINO_ARCH_RP2040)
+// Hardware alarm callbacks get no context pointer: map alarm number to display
+#define TM1637_ALARMS 4
+static TM1637Display32* tm1637_alarmDisplays[TM1637_ALARMS];
+#endif
+
+bool TM1637Display32::beginTimer(uint16_t step_us) {
+  if (m_timerActive) return true;
+  #if TM1637_HAS_PIO
+  if (m_pioActive) return false;  // PIO needs no ticks
+  #endif
+  #if TM1637_HAS_RMT
+  if (m_rmtActive) return false;  // RMT needs no ticks
+  #endif
+
+  #if defined(ARDUINO_ARCH_RP2040)
+  int alarm = hardware_alarm_claim_unused(false);
+  if (alarm < 0 || alarm >= TM1637_ALARMS) return false;
+  m_timerAlarm = alarm;
+  tm1637_alarmDisplays[alarm] = this;
+  hardware_alarm_set_callback((uint)alarm, timerAlarm);
+  #else
+  esp_timer_create_args_t args;
+  memset(&args, 0, sizeof(args));
+  args.callback = timerTick;
+  args.arg = this;
+  // From the esp_timer task, not ESP_TIMER_ISR: update() and all it calls
+  // (the state machine, animations, the font) are in flash, which an
+  // interrupt cannot run while the cache is off for a flash write
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "tm1637";
+  if (esp_timer_create(&args, &m_timer) != ESP_OK) return false;
+  #endif
+
+  m_timerStepUs = step_us;
+  #if TM1637_PACING
+  setTickPeriod(step_us);  // The timer paces update(), no clock reads per tick
+  #endif
+  m_timerActive = true;
+  if (!isIdle()) timerArm();  // Carry on with whatever is already underway
+  else timerIdle();
+  return true;
+}
+
+void TM1637Display32::timerArm() {
+  timerArmIn(m_timerStepUs);
+}
+
+void TM1637Display32::timerArmIn(uint32_t delay_us) {
+  #if defined(ARDUINO_ARCH_RP2040)
+  // Reports a target already in the past: tick late rather than never
+  if (hardware_alarm_set_target((uint)m_timerAlarm, make_timeout_time_us(delay_us))) {
+    hardware_alarm_force_irq((uint)m_timerAlarm);
+  }
+  #else
+  esp_timer_start_once(m_timer, delay_us);  // Fails harmlessly if already armed
+  #endif
+}
+
+void TM1637Display32::timerIdle() {
+  uint32_t wait = idleWait();
+  if (wait == TM1637_NOTHING_DUE) return;  // Nothing scheduled: stay disarmed
+  if (wait < m_timerStepUs) wait = m_timerStepUs;
+  timerArmIn(wait);
+}
+
+#if defined(ARDUINO_ARCH_RP2040)
+void TM1637Display32::timerAlarm(uint alarm) {
+  TM1637Display32* display = tm1637_alarmDisplays[alarm];
+  if (!display->update()) display->timerArm();
+  else display->timerIdle();
+}
+#else
+// Runs in the esp_timer task. The one-shot timer has fired, so it is
+// disarmed and esp_timer_start_once() from here re-arms it for the next step.
+void TM1637Display32::timerTick(void* arg) {
+  TM1637Display32* display = (TM1637Display32*)arg;
+  if (!display->update()) display->timerArm();
+  else display->timerIdle();  // Stop stepping once idle, wake for the next animation frame
+}
+#endif
+#endif
+
+void TM1637Display32::clear() {
+  uint8_t data[TM1637_MAX_DIGITS] = { 0 };
+  setSegments(data, m_digitCount);
+}
+
+void TM1637Display32::showNumberDec(int32_t num, bool leading_zero, uint8_t length, uint8_t pos) {
+  showNumberDecEx(num, 0, leading_zero, length, pos);
+}
+
+void TM1637Display32::showNumberDecEx(int32_t num, uint8_t dots, bool leading_zero,
+                                    uint8_t length, uint8_t pos) {
+  if (length > m_digitCount) length = m_digitCount;
+  uint32_t magnitude = num < 0 ? 0 - (uint32_t)num : (uint32_t)num;
+  uint8_t digits[10];
+  uint8_t count = decimalDigits(magnitude, digits);
+  showDigits(digits, count, num < 0, dots, leading_zero, length, pos);
+}
+
+void TM1637Display32::showNumberDecChecked(int32_t num, uint8_t dots, bool leading_zero,
+                                           uint8_t length, uint8_t pos) {
+  if (length > m_digitCount) length = m_digitCount;
+  uint32_t magnitude = num < 0 ? 0 - (uint32_t)num : (uint32_t)num;
+  uint8_t digits[10];
+  uint8_t count = decimalDigits(magnitude, digits);
+  if (count + (num < 0 ? 1 : 0) > length) {
+    showOverflow(length, pos);  // Low digits alone would be a wrong number
+    return;
+  }
+  showDigits(digits, count, num < 0, dots, leading_zero, length, pos);
+}
+
+void TM1637Display32::showNumberHexEx(uint16_t num, uint8_t dots,
+                                    bool leading_zero, uint8_t length,
+                                    uint8_t pos) {
+  showNumberBaseEx(16, num, dots, leading_zero, length, pos);
+}
+
+void TM1637Display32::showNumberBaseEx(int8_t base, uint16_t num, uint8_t dots,
+                                     bool leading_zero, uint8_t length,
+                                     uint8_t pos) {
+  bool negative = false;
+  if (base < 0) {
+    base = -base;
+    negative = true;
+  }
+
+  uint8_t digits[10];
+  uint8_t count;
+  if (base == 16) {
+    count = 0;
+    do {
+      digits[count++] = num & 0x0f;
+      num >>= 4;
+    } while (num != 0);
+  } else {
+    count = decimalDigits(num, digits);
+  }
+  showDigits(digits, count, negative, dots, leading_zero, length, pos);
+}
+
+void TM1637Display32::showFixed(int32_t value, uint8_t decimals, uint8_t length, uint8_t pos) {
+  if (length > m_digitCount) length = m_digitCount;
+  uint32_t magnitude = value < 0 ? 0 - (uint32_t)value : (uint32_t)value;
+  uint8_t digits[11];
+  uint8_t count = decimalDigits(magnitude, digits);
+  if (decimals > 9) decimals = 9;
+
+  while (count < decimals + 1) digits[count++] = 0;  // Leading zero: 0.05
+
+  // Give up decimals, with rounding, until the number fits
+  uint8_t sign = value < 0 ? 1 : 0;
+  if (count + sign > length && decimals > 0) {
+    uint8_t drop = count + sign - length;
+    if (drop > decimals) drop = decimals;
+    dropDigits(digits, count, drop);
+    decimals -= drop;
+    if (count + sign > length && decimals > 0) {
+      dropDigits(digits, count, 1);  // Carried into a new digit: 99.96 -> 100.0
+      decimals--;
+    }
+  }
+
+  bool negative = value < 0;
+  for (uint8_t k = 0; k < count && negative; k++) {
+    if (digits[k] != 0) break;
+    if (k == count - 1) negative = false;  // Rounded to zero: no "-0"
+  }
+  if (count + (negative ? 1 : 0) > length) {
+    showOverflow(length, pos);  // Too large even without decimals
+    return;
+  }
+  uint8_t dots = decimals ? (uint8_t)(0x80 >> (length - 1 - decimals)) : 0;
+  showDigits(digits, count, negative, dots, false, length, pos);
+}
+
+void TM1637Display32::showOverflow(uint8_t length, uint8_t pos) {
+  if (length > m_digitCount) length = m_digitCount;
+  uint8_t dashes[TM1637_MAX_DIGITS];
+  memset(dashes, minusSegments, sizeof(dashes));
+  setSegments(dashes, length, pos);
+}
+
+// Right-align count digits (least significant first) in a field of length
+// digits; blanks (or zeros) in front, a minus sign right before the number.
+// As before, numbers wider than the field show their low digits.
+void TM1637Display32::showDigits(const uint8_t digits[], uint8_t count, bool negative,
+                                 uint8_t dots, bool leading_zero, uint8_t length,
+                                 uint8_t pos) {
+  if (length > m_digitCount) length = m_digitCount;
+  uint8_t segs[TM1637_MAX_DIGITS];
+  for (uint8_t k = 0; k < length; k++) {
+    uint8_t i = length - 1 - k;
+    if (k < count) {
+      segs[i] = encodeDigit(digits[k]);
+    } else if (negative) {
+      segs[i] = minusSegments;
+      negative = false;
+    } else {
+      segs[i] = leading_zero ? encodeDigit(0) : 0;
+    }
+  }
+
+  if (dots != 0) {
+    showDots(dots, segs, length);
+  }
+  setSegments(segs, length, pos);
+}
+
+void TM1637Display32::showDots(uint8_t dots, uint8_t* digits, uint8_t length) {
+  for (uint8_t i = 0; i < length; ++i) {
+    digits[i] |= (dots & 0x80);
+    dots <<= 1;
+  }
+}
+
+uint8_t TM1637Display32::encodeDigit(uint8_t digit) {
+  return TM1637_PGM_READ(&digitToSegment[digit & 0x0f]);
+}
+
+uint8_t TM1637Display32::charToSeg(char c) {
+  uint8_t index = (uint8_t)c - 0x20;
+  if (index >= sizeof(asciiToSegment)) return 0x00;  // unknown character = blank
+  return TM1637_PGM_READ(&asciiToSegment[index]);
+}
+
+void TM1637Display32::displayText(const char* text, uint8_t pos) {
+  uint8_t segs[TM1637_MAX_DIGITS] = {0};
+  int maxLen = m_digitCount - pos;
+  int textLen = strlen(text);
+  int len = (maxLen < textLen) ? maxLen : textLen;
+  for (int i = 0; i < len; i++) {
+    segs[pos + i] = charToSeg(text[i]);
+  }
+  setSegments(segs, m_digitCount);
+}
+
+void TM1637Display32::showEncoded(const uint8_t segments[], uint8_t length, uint8_t pos) {
+  uint8_t segs[TM1637_MAX_DIGITS] = {0};
+  uint8_t room = (pos < m_digitCount) ? m_digitCount - pos : 0;
+  if (length > room) length = room;
+  if (length > 0) memcpy(&segs[pos], segments, length);
+  setSegments(segs, m_digitCount);
+}
+
+void TM1637Display32::displayCharAndNumber(char c, int number) {
+  uint8_t segs[4];
+  segs[0] = charToSeg(c);
+
+  // Format number for 3 digits (positions 1-3)
+  uint32_t absNum = number < 0 ? 0 - (uint32_t)number : (uint32_t)number;
+  uint8_t digits[10];
+  decimalDigits(absNum, digits);
+  if (absNum >= 10000) {
+    // 10000+: show as XX.X (e.g., 12300 -> "12.3")
+    segs[1] = encodeDigit(digits[4]);
+    segs[2] = encodeDigit(digits[3]) | SEG_DP;
+    segs[3] = encodeDigit(digits[2]);
+  } else if (absNum >= 1000) {
+    // 1000-9999: show as X.XK (e.g., 1024 -> "1.0K", 5678 -> "5.6K")
+    segs[1] = encodeDigit(digits[3]) | SEG_DP;  // First two significant digits
+    segs[2] = encodeDigit(digits[2]);
+    segs[3] = charToSeg('K');
+  } else {
+    // 0-999: show as is, right-aligned, blank leading zeros
+    segs[1] = (absNum >= 100) ? encodeDigit(digits[2]) : 0;
+    segs[2] = (absNum >= 10) ? encodeDigit(digits[1]) : 0;
+    segs[3] = encodeDigit(digits[0]);
+    // Handle negative
+    if (number < 0 && absNum < 100) {
+      segs[1] = SEG_G;  // Minus sign
+    }
+  }
+  setSegments(segs, 4, 0);
+}
+
+#if TM1637_SCROLL
+bool TM1637Display32::startScroll(const char* text, uint16_t interval_ms, uint8_t pad_spaces) {
+  if (!animClaim()) return false;  // The scroll state is the engine's until then
+  // The caller's buffer may be gone before the scroll ends
+  uint8_t length = 0;
+  while (length < TM1637_SCROLL_COPY && text[length] != '\0') {
+    m_scrollCopy[length] = text[length];
+    length++;
+  }
+  m_scrollCopy[length] = '\0';
+  m_animData.text = m_scrollCopy;
+  beginScroll(SCROLL_TEXT, interval_ms, pad_spaces);
+  return true;
+}
+
+bool TM1637Display32::startScrollBorrowed(const char* text, uint16_t interval_ms,
+                                          uint8_t pad_spaces) {
+  if (!animClaim()) return false;
+  m_animData.text = text;
+  beginScroll(SCROLL_TEXT, interval_ms, pad_spaces);
+  return true;
+}
+
+bool TM1637Display32::startScroll(const __FlashStringHelper* text, uint16_t interval_ms,
+                                  uint8_t pad_spaces) {
+  if (!animClaim()) return false;
+  m_animData.text = (const char*)text;
+  beginScroll(SCROLL_FLASH, interval_ms, pad_spaces);
+  return true;
+}
+
+bool TM1637Display32::startScroll(TM1637ScrollReader reader, void* ctx, uint16_t interval_ms,
+                                  uint8_t pad_spaces) {
+  if (!animClaim()) return false;
+  m_animData.reader = reader;
+  m_scrollCtx = ctx;
+  beginScroll(SCROLL_READER, interval_ms, pad_spaces);
+  return true;
+}
+
+bool TM1637Display32::startScrollEncoded(const uint8_t segments[], uint16_t length,
+                                         uint16_t interval_ms, uint8_t pad_spaces) {
+  if (!animClaim()) return false;
+  m_animData.segments = segments;
+  m_scrollLength = length;
+  beginScroll(SCROLL_SEGMENTS, interval_ms, pad_spaces);
+  return true;
+}
+
+// Caller holds the claim, from animClaim()
+void TM1637Display32::beginScroll(uint8_t kind, uint16_t interval_ms, uint8_t pad_spaces) {
+  // Virtual message: pad_spaces blanks + source + pad_spaces blanks
+  m_scrollKind = kind;
+  m_scrollIndex = 0;
+  m_scrollLead = pad_spaces;
+  m_scrollTrail = pad_spaces;
+  m_scrollEnd = false;
+
+  // Display first frame (blank past the end of a short message)
+  for (uint8_t i = 0; i < m_digitCount; i++) {
+    if (!scrollNext(m_scrollWindow[i])) m_scrollWindow[i] = 0x00;
+  }
+  m_scrollActive = true;
+  animBegin(ANIM_SCROLL, (uint32_t)interval_ms * 1000);
+}
+
+bool TM1637Display32::scrollNext(uint8_t& segments) {
+  if (m_scrollLead > 0) {
+    m_scrollLead--;
+    segments = 0x00;
+    return true;
+  }
+
+  if (!m_scrollEnd) {
+    char c;
+    switch (m_scrollKind) {
+      case SCROLL_SEGMENTS:
+        if (m_scrollIndex < m_scrollLength) {
+          segments = m_animData.segments[m_scrollIndex++];
+          return true;
+        }
+        c = '\0';
+        break;
+      case SCROLL_FLASH:
+        c = (char)TM1637_PGM_READ(&m_animData.text[m_scrollIndex]);
+        break;
+      case SCROLL_READER:
+        c = m_animData.reader(m_scrollIndex, m_scrollCtx);
+        break;
+      default:
+        c = m_animData.text[m_scrollIndex];
+        break;
+    }
+    if (c != '\0') {
+      m_scrollIndex++;
+      segments = charToSeg(c);
+      return true;
+    }
+    m_scrollEnd = true;
+  }
+
+  if (m_scrollTrail > 0) {
+    m_scrollTrail--;
+    segments = 0x00;
+    return true;
+  }
+  return false;
+}
+
+bool TM1637Display32::updateScroll() {
+  animate();  // Nothing to do if update() got there first
+  return !isScrolling();
+}
+
+bool TM1637Display32::isScrolling() const {
+  return m_scrollActive && m_animStops == m_animStopsDone;
+}
+
+void TM1637Display32::stopScroll() {
+  if (m_scrollActive) stopAnimation();
+}
+
+bool TM1637Display32::play(const TM1637Frame frames[], uint8_t count, uint8_t mode) {
+  if (!animClaim()) return false;
+  if (count == 0) {
+    releaseClaim();
+    return true;
+  }
+  m_animData.frames = frames;
+  m_animCount = count;
+  m_animIndex = 0;
+  m_animMode = mode;
+  m_animDir = 1;
+  animBegin(ANIM_FRAMES, (uint32_t)frames[0].duration_ms * 1000);
+  return true;
+}
+
+// Take the claim for a new animation or scroll and stop the current one.
+// Never waits: false if an animation step holds it on another core or in the
+// code this call interrupted.
+bool TM1637Display32::animClaim() {
+  if (!tryClaim()) return false;
+  m_animStopsDone = m_animStops;  // Stops asked for so far end the old one only
+  m_animSource = ANIM_NONE;
+  m_scrollActive = false;
+  return true;
+}
+
+// Show the first frame of the source set up by the caller and start the
+// clock. Caller holds the claim, from animClaim(); released here.
+void TM1637Display32::animBegin(uint8_t source, uint32_t duration_us) {
+  m_animStart = micros();
+  m_animDurationUs = duration_us;
+  if (source == ANIM_SCROLL) postSegments(m_scrollWindow, m_digitCount, 0);
+  else postSegments(m_animData.frames[0].segments, 4, 0);
+  TM1637_FENCE();
+  m_animSource = source;
+  releaseClaim();
+
+  kick();
+  notifyPost();
+  #if TM1637_HAS_TIMER
+  if (m_timerActive && isIdle()) timerIdle();  // Frame already on the chip
+  #endif
+}
+
+void TM1637Display32::stopAnimation() {
+  // Applied by whoever steps the animation next, like invalidate(): right
+  // here unless a step is in progress elsewhere
+  m_animStops++;
+  if (!tryClaim()) return;
+  animStops();
+  releaseClaim();
+}
+
+// Caller holds the claim
+void TM1637Display32::animStops() {
+  uint8_t stops = m_animStops;
+  if (stops == m_animStopsDone) return;
+  m_animStopsDone = stops;
+  m_animSource = ANIM_NONE;
+  m_scrollActive = false;
+}
+
+bool TM1637Display32::isAnimating() const {
+  return m_animSource != ANIM_NONE && m_animStops == m_animStopsDone;
+}
+
+#if TM1637_HOOKS
+void TM1637Display32::onAnimationDone(TM1637AnimationHook hook, void* ctx) {
+  m_animHook = NULL;
+  TM1637_FENCE();
+  m_animHookCtx = ctx;
+  TM1637_FENCE();
+  m_animHook = hook;
+}
+#endif
+
+void TM1637Display32::animate() {
+  if (m_animSource == ANIM_NONE) return;
+  if (!tryClaim()) return;  // Somebody else is posting or animating: next time
+  animStops();
+  uint8_t step = animStep();
+  releaseClaim();
+
+  if (step == ANIM_POSTED) {
+    kick();
+    notifyPost();
+  }
+  #if TM1637_HOOKS
+  if (step == ANIM_DONE) {
+    TM1637AnimationHook hook = m_animHook;
+    if (hook) hook(m_animHookCtx);
+  }
+  #endif
+}
+
+// Caller holds the claim. Posts the next frame once the current one is due
+// and has reached the chip.
+uint8_t TM1637Display32::animStep() {
+  if (m_animSource == ANIM_NONE) return ANIM_WAIT;
+  uint32_t now = micros();
+  if ((uint32_t)(now - m_animStart) < m_animDurationUs) return ANIM_WAIT;
+  if (!isIdle()) return ANIM_WAIT;
+
+  if (m_animSource == ANIM_SCROLL) {
+    uint8_t next;
+    if (!scrollNext(next)) {
+      m_animSource = ANIM_NONE;
+      m_scrollActive = false;
+      return ANIM_DONE;
+    }
+    // Shift the window left by one digit; only the new digit is encoded
+    memmove(m_scrollWindow, m_scrollWindow + 1, m_digitCount - 1);
+    m_scrollWindow[m_digitCount - 1] = next;
+    postSegments(m_scrollWindow, m_digitCount, 0);
+  } else {
+    int16_t next = m_animIndex + m_animDir;
+    if (next >= m_animCount || next < 0) {
+      if (m_animMode == TM1637_PLAY_ONCE) {
+        m_animSource = ANIM_NONE;
+        return ANIM_DONE;
+      } else if (m_animMode == TM1637_PLAY_PINGPONG && m_animCount > 1) {
+        m_animDir = -m_animDir;
+        next = m_animIndex + m_animDir;
+      } else {
+        next = 0;
+      }
+    }
+    m_animIndex = (uint8_t)next;
+    postSegments(m_animData.frames[m_animIndex].segments, 4, 0);
+  }
+
+  // Keep to the schedule; after falling a whole frame behind, restart it
+  m_animStart += m_animDurationUs;
+  if (m_animSource == ANIM_FRAMES) {
+    m_animDurationUs = (uint32_t)m_animData.frames[m_animIndex].duration_ms * 1000;
+  }
+  if ((uint32_t)(now - m_animStart) >= m_animDurationUs) m_animStart = now;
+  return ANIM_POSTED;
+}
+#endif
+
+#if TM1637_EFFECTS
+bool TM1637Display32::fadeTo(uint8_t level, uint16_t duration_ms, bool on) {
+  level &= 0x07;
+  if (!tryClaim()) return false;  // An effect step is in progress elsewhere
+  effectStops();
+  uint8_t current = m_brightness & 0x07;
+  uint8_t steps = (level > current) ? level - current : current - level;
+  m_fading = false;
+  if (steps == 0 || duration_ms == 0) {
+    m_brightness = level | (on ? 0x08 : 0x00);
+    postSegments(NULL, 0, 0);
+  } else {
+    if (!m_blinking) m_brightness |= 0x08;  // Visible while it fades
+    m_fadeTarget = level;
+    m_fadeOn = on;
+    m_fadeIntervalUs = (uint32_t)duration_ms * 1000 / steps;
+    m_fadeStart = micros();
+    postSegments(NULL, 0, 0);
+    TM1637_FENCE();
+    m_fading = true;
+  }
+  releaseClaim();
+
+  kick();
+  notifyPost();
+  #if TM1637_HAS_TIMER
+  if (m_timerActive && isIdle()) timerIdle();
+  #endif
+  return true;
+}
+
+bool TM1637Display32::blink(uint16_t on_ms, uint16_t off_ms, uint8_t count) {
+  if (!tryClaim()) return false;
+  effectStops();  // Earlier stopBlink() calls are for the old blink
+  m_blinkOnUs = (uint32_t)on_ms * 1000;
+  m_blinkOffUs = (uint32_t)off_ms * 1000;
+  m_blinkLeft = count;
+  m_blinkOff = false;
+  m_blinkStart = micros();
+  m_brightness |= 0x08;  // Starts with the on half
+  postSegments(NULL, 0, 0);
+  TM1637_FENCE();
+  m_blinking = true;
+  releaseClaim();
+
+  kick();
+  notifyPost();
+  #if TM1637_HAS_TIMER
+  if (m_timerActive && isIdle()) timerIdle();
+  #endif
+  return true;
+}
+
+void TM1637Display32::stopBlink() {
+  m_blinkStops++;  // Applied like stopAnimation()
+  if (!tryClaim()) return;
+  bool posted = effectStops();
+  releaseClaim();
+
+  if (posted) {
+    kick();
+    notifyPost();
+  }
+}
+
+// Caller holds the claim. Applies the setBrightness() and stopBlink() calls
+// that found an effect step in progress; true if it posted.
+bool TM1637Display32::effectStops() {
+  uint8_t stops = m_effectStops;
+  if (stops != m_effectStopsDone) {
+    TM1637_FENCE();
+    m_fading = false;
+    m_blinking = false;
+    m_brightness = m_brightnessRequest;
+    m_effectStopsDone = stops;
+  }
+  stops = m_blinkStops;
+  if (stops == m_blinkStopsDone) return false;
+  m_blinkStopsDone = stops;
+  bool wasOff = m_blinking && m_blinkOff;
+  m_blinking = false;
+  if (!wasOff) return false;
+  m_brightness |= 0x08;  // Left on
+  postSegments(NULL, 0, 0);
+  return true;
+}
+
+bool TM1637Display32::isFading() const {
+  return m_fading && m_effectStops == m_effectStopsDone;
+}
 
-// Minimum microseconds between state changes
-// TM1637 datasheet specifies ~1µs minimum, but we use more for reliability
-// ESP32/RP2040 require longer delays for reliable non-blocking operation
-#if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-#define BIT_DELAY_US 100  // Matches proven 10kHz ISR timing; gives margin for RTOS preemption
-#else
-#define BIT_DELAY_US 0    // AVR is slow enough that no delay needed
-#endif
+bool TM1637Display32::isBlinking() const {
+  return m_blinking && m_effectStops == m_effectStopsDone && m_blinkStops == m_blinkStopsDone;
+}
 
-const uint8_t digitToSegment[] = {
-  // XGFEDCBA
-  0b00111111,    // 0
-  0b00000110,    // 1
-  0b01011011,    // 2
-  0b01001111,    // 3
-  0b01100110,    // 4
-  0b01101101,    // 5
-  0b01111101,    // 6
-  0b00000111,    // 7
-  0b01111111,    // 8
-  0b01101111,    // 9
-  0b01110111,    // A
-  0b01111100,    // b
-  0b00111001,    // C
-  0b01011110,    // d
-  0b01111001,    // E
-  0b01110001     // F
-};
+void TM1637Display32::brightnessEffects() {
+  if (!m_fading && !m_blinking) return;
+  if (!tryClaim()) return;  // Somebody else is posting: next time
+  bool posted = effectStops();
+  if (brightnessStep()) posted = true;
+  releaseClaim();
 
-static const uint8_t minusSegments = 0b01000000;
+  if (posted) {
+    kick();  // COMM3 only, unless digits were posted as well
+    notifyPost();
+  }
+}
 
-// Character segment patterns: A-Z (0-25), 0-9 (26-35), space (36), dash (37)
-static const uint8_t charToSegment[] = {
-  SEG_A | SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,         // A
-  SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,                 // b
-  SEG_A | SEG_D | SEG_E | SEG_F,                         // C
-  SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,                 // d
-  SEG_A | SEG_D | SEG_E | SEG_F | SEG_G,                 // E
-  SEG_A | SEG_E | SEG_F | SEG_G,                         // F
-  SEG_A | SEG_C | SEG_D | SEG_E | SEG_F,                 // G
-  SEG_C | SEG_E | SEG_F | SEG_G,                         // h
-  SEG_E | SEG_F,                                         // I
-  SEG_B | SEG_C | SEG_D | SEG_E,                         // J
-  SEG_C | SEG_E | SEG_F | SEG_G,                         // k (same as h)
-  SEG_D | SEG_E | SEG_F,                                 // L
-  SEG_A | SEG_C | SEG_E | SEG_G,                         // M (stylized)
-  SEG_C | SEG_E | SEG_G,                                 // n
-  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,         // O
-  SEG_A | SEG_B | SEG_E | SEG_F | SEG_G,                 // P
-  SEG_A | SEG_B | SEG_C | SEG_F | SEG_G,                 // q
-  SEG_E | SEG_G,                                         // r
-  SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                 // S
-  SEG_D | SEG_E | SEG_F | SEG_G,                         // t
-  SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,                 // U
-  SEG_C | SEG_D | SEG_E,                                 // v
-  SEG_B | SEG_D | SEG_F | SEG_G,                         // W (stylized)
-  SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,                 // X (same as H)
-  SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,                 // y
-  SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,                 // Z
-  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,         // 0
-  SEG_B | SEG_C,                                         // 1
-  SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,                 // 2
-  SEG_A | SEG_B | SEG_C | SEG_D | SEG_G,                 // 3
-  SEG_B | SEG_C | SEG_F | SEG_G,                         // 4
-  SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                 // 5
-  SEG_A | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,         // 6
-  SEG_A | SEG_B | SEG_C,                                 // 7
-  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G, // 8
-  SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,         // 9
-  0x00,                                                  // space
-  SEG_G                                                  // dash
-};
+// Caller holds the claim. Moves the fade one level and/or the blink one
+// half along if due, on the same drift-free schedule as the animations.
+bool TM1637Display32::brightnessStep() {
+  uint32_t now = micros();
+  bool changed = false;
+
+  if (m_fading && (uint32_t)(now - m_fadeStart) >= m_fadeIntervalUs) {
+    uint8_t level = m_brightness & 0x07;
+    level = (level < m_fadeTarget) ? level + 1 : level - 1;
+    m_brightness = (m_brightness & ~0x07) | level;
+    if (level == m_fadeTarget) {
+      if (!m_fadeOn) m_brightness &= ~0x08;
+      m_fading = false;
+    }
+    m_fadeStart += m_fadeIntervalUs;
+    if ((uint32_t)(now - m_fadeStart) >= m_fadeIntervalUs) m_fadeStart = now;
+    changed = true;
+  }
 
-TM1637Display32::TM1637Display32(uint8_t pinClk, uint8_t pinDIO) {
-  m_pinClk = pinClk;
-  m_pinDIO = pinDIO;
+  if (m_blinking) {
+    uint32_t half = m_blinkOff ? m_blinkOffUs : m_blinkOnUs;
+    if ((uint32_t)(now - m_blinkStart) >= half) {
+      m_blinkOff = !m_blinkOff;
+      if (m_blinkOff) {
+        m_brightness &= ~0x08;
+      } else {
+        m_brightness |= 0x08;
+        if (m_blinkLeft && --m_blinkLeft == 0) m_blinking = false;  // Last blink done
+      }
+      m_blinkStart += half;
+      half = m_blinkOff ? m_blinkOffUs : m_blinkOnUs;
+      if ((uint32_t)(now - m_blinkStart) >= half) m_blinkStart = now;
+      changed = true;
+    }
+  }
+
+  if (changed) postSegments(NULL, 0, 0);
+  return changed;
+}
+#endif
+
+TM1637MultiDisplay::TM1637MultiDisplay(uint8_t pinClk, const uint8_t pinsDIO[], uint8_t count) {
+  init(&pinClk, 1, pinsDIO, count);
+}
+
+TM1637MultiDisplay::TM1637MultiDisplay(const uint8_t pinsClk[], const uint8_t pinsDIO[], uint8_t count) {
+  init(pinsClk, count, pinsDIO, count);
+}
+
+void TM1637MultiDisplay::init(const uint8_t pinsClk[], uint8_t clkCount,
+                              const uint8_t pinsDIO[], uint8_t count) {
+  if (count > TM1637_MULTI_MAX) count = TM1637_MULTI_MAX;
+  if (clkCount > count) clkCount = count;
+  m_count = count;
+  m_clkCount = clkCount;
+  m_allDisplays = (uint16_t)((1u << count) - 1);
   m_brightness = 0x0F;  // Max brightness (7) + display ON (0x08)
+  m_seq = 0;
+  m_posted = false;
   m_counter = 255;  // Idle state (no transmission pending)
+  m_phase = 0;
+  m_bit_count = 0;
+  m_bitDelayUs = BIT_DELAY_US;
   m_lastUpdateMicros = 0;
-  m_transmissionStartMillis = 0;
-  m_lastTransmissionMillis = 0;
-  m_minIntervalMillis = 0;  // No throttle by default
-  m_scrollActive = false;
-  m_scrollLength = 0;
-  m_scrollPos = 0;
+  m_nack = 0;
+  m_missing = 0;
+  m_clkLow = false;
+  m_clkOut = false;
+  m_dioLow = 0;
+  m_dioOut = 0;
+  memset(m_digits, 0, sizeof(m_digits));
+
+  for (uint8_t i = 0; i < clkCount; i++) {
+    m_pinsClk[i] = pinsClk[i];
+    pinSetup(pinsClk[i]);
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    m_pinsDIO[i] = pinsDIO[i];
+    pinSetup(pinsDIO[i]);
+  }
 
-  // Pre-set output latch to LOW (for when we switch to OUTPUT mode)
-  digitalWrite(m_pinClk, LOW);
-  digitalWrite(m_pinDIO, LOW);
+  #if TM1637_FAST_GPIO
+  // Group the pins by output-enable register, so a step is one write per group
+  m_ports = 0;
+  m_clkSlow = false;
+  for (uint8_t i = 0; i < clkCount; i++) {
+    tm1637_mask_t mask;
+    m_clkPort[i] = portFor(pinsClk[i], &mask);
+    if (m_clkPort[i] == 0xFF) m_clkSlow = true;
+    else m_portClk[m_clkPort[i]] |= mask;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    m_dioPort[i] = portFor(pinsDIO[i], &m_dioMask[i]);
+    m_dioIn[i] = pinInputRegister(pinsDIO[i]);  // Same mask as the output enable
+  }
+  #endif
+}
 
-  // Both pins are set as inputs with pull-ups for open-drain signaling
-  #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-  pinMode(m_pinClk, INPUT_PULLUP);
-  pinMode(m_pinDIO, INPUT_PULLUP);
+#if TM1637_FAST_GPIO
+// Index of the port group for a pin, added if new (0xFF if the table is full)
+uint8_t TM1637MultiDisplay::portFor(uint8_t pin, tm1637_mask_t* mask) {
+  tm1637_reg_t* oeSet;
+  tm1637_reg_t* oeClr;
+  pinRegisters(pin, &oeSet, &oeClr, mask);
+  for (uint8_t p = 0; p < m_ports; p++) {
+    if (m_portSet[p] == oeSet) return p;
+  }
+  if (m_ports == TM1637_MULTI_PORTS) return 0xFF;
+  m_portSet[m_ports] = oeSet;
+  m_portClr[m_ports] = oeClr;
+  m_portClk[m_ports] = 0;
+  return m_ports++;
+}
+
+void TM1637MultiDisplay::portWrite(uint8_t port, tm1637_mask_t low, tm1637_mask_t release) {
+  #if defined(__AVR__)
+  uint8_t oldSREG = SREG;  // DDRx read-modify-write, same guard as pinMode()
+  cli();
+  *m_portSet[port] = (*m_portSet[port] | low) & ~release;
+  SREG = oldSREG;
   #else
-  pinMode(m_pinClk, INPUT);
-  pinMode(m_pinDIO, INPUT);
+  if (low) *m_portSet[port] = low;  // Enable output, latch is already LOW
+  if (release) *m_portClr[port] = release;  // Disable output, pull-up takes over
   #endif
 }
+#endif
 
-void TM1637Display32::setBrightness(uint8_t brightness, bool on) {
+void TM1637MultiDisplay::setBrightness(uint8_t brightness, bool on) {
   m_brightness = (brightness & 0x7) | (on ? 0x08 : 0x00);
+  m_posted = true;
 }
 
-void TM1637Display32::setSegments(const uint8_t segments[], uint8_t length, uint8_t pos) {
-  // Was the state machine already idle? If so, skip the heavy bus reset.
-  bool wasIdle = (m_counter == 255);
-
-  // Keep state machine idle during setup to prevent ISR conflicts
-  m_counter = 255;
-
-  // Copy segment data
-  memset(m_segments, 0, 4);
-  if (length > 4) length = 4;
-  memcpy(m_segments, segments, length);
-
-  m_pos = pos;
-  m_length = length;
-
-  if (wasIdle) {
-    // Bus is in a known-good state (both lines HIGH from previous stop condition).
-    // Just ensure lines are HIGH then issue START — no reset needed.
-    #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-    pinMode(m_pinClk, INPUT_PULLUP);
-    pinMode(m_pinDIO, INPUT_PULLUP);
-    #else
-    pinMode(m_pinClk, INPUT);
-    pinMode(m_pinDIO, INPUT);
-    #endif
-    delayMicroseconds(5);
-  } else {
-    // Mid-transaction abort: force a clean stop to reset the TM1637
-    // Stop sequence: CLK LOW -> DIO LOW -> CLK HIGH -> DIO HIGH
-    pinMode(m_pinClk, OUTPUT);
-    digitalWrite(m_pinClk, LOW);
-    delayMicroseconds(5);
-    pinMode(m_pinDIO, OUTPUT);
-    digitalWrite(m_pinDIO, LOW);
-    delayMicroseconds(5);
-    #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-    pinMode(m_pinClk, INPUT_PULLUP);  // CLK HIGH
-    #else
-    pinMode(m_pinClk, INPUT);
-    #endif
-    delayMicroseconds(5);
-    #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-    pinMode(m_pinDIO, INPUT_PULLUP);  // DIO HIGH (stop condition)
-    #else
-    pinMode(m_pinDIO, INPUT);
-    #endif
-    delayMicroseconds(1200);  // Datasheet: reset both lines high for >1ms after error
+void TM1637MultiDisplay::setSegments(uint8_t display, const uint8_t segments[],
+                                     uint8_t length, uint8_t pos) {
+  if (display >= m_count) return;
+
+  // Post into the mailbox; the sequence count is odd while it is being written
+  m_seq++;
+  TM1637_FENCE();
+  for (uint8_t i = 0; i < length && pos + i < 4; i++) {
+    m_digits[display][pos + i] = segments[i];
   }
+  TM1637_FENCE();
+  m_seq++;
+  TM1637_FENCE();
+  m_posted = true;
+}
 
-  // Start condition: DIO goes LOW while CLK is HIGH
-  pinMode(m_pinDIO, OUTPUT);
-  digitalWrite(m_pinDIO, LOW);
-  delayMicroseconds(10);  // Let TM1637 recognize start condition
+void TM1637MultiDisplay::clear(uint8_t display) {
+  uint8_t data[] = { 0, 0, 0, 0 };
+  setSegments(display, data);
+}
 
-  m_lastUpdateMicros = micros();
-  m_transmissionStartMillis = millis();  // For watchdog timeout
-  m_lastTransmissionMillis = m_transmissionStartMillis;  // For update throttling
+bool TM1637MultiDisplay::isIdle() const {
+  return m_counter == 255 && !m_posted;
+}
 
-  // NOW enable state machine - after all blocking GPIO work is done
-  // This prevents ISR from conflicting with the setup sequence above
-  m_phase = 0;
-  m_bit_count = 0;
-  m_byte = TM1637_I2C_COMM1;
-  m_counter = 0;  // Start transmission (must be last!)
+bool TM1637MultiDisplay::pump(unsigned long timeout_us) {
+  unsigned long start = micros();
+  while ((micros() - start) < timeout_us) {
+    if (update()) return true;  // idle or complete
+  }
+  return false;  // timed out, transmission still in progress
 }
 
-bool TM1637Display32::update() {
-  // Check if transmission is complete or idle
-  if (m_counter == 255) {
-    return true;  // No transmission in progress
+// Take a consistent snapshot of the mailbox for the next frame
+bool TM1637MultiDisplay::startFrame() {
+  m_posted = false;
+  TM1637_FENCE();
+  uint8_t seq = m_seq;
+  memcpy(m_frame, m_digits, sizeof(m_frame));
+  m_frameBrightness = m_brightness;
+  TM1637_FENCE();
+  if ((seq & 1) || m_seq != seq) {
+    m_posted = true;  // Torn by a post in progress: try again next tick
+    return false;
   }
+  return true;
+}
 
-  // Watchdog: if transmission takes too long, reset to idle
-  // When driven by ISR at 10kHz, a transmission takes ~20ms.
-  // When polled from loop(), it can take 50-150ms depending on loop load.
-  // Allow 500ms as generous timeout to avoid aborting valid transmissions.
-  unsigned long nowMillis = millis();
-  if ((nowMillis - m_transmissionStartMillis) > 500) {
-    m_counter = 255;  // Force idle - transmission timed out
-    return true;
+bool TM1637MultiDisplay::update() {
+  if (m_counter == 255) {
+    if (!m_posted || !startFrame()) return !m_posted;
+    m_nack = 0;
+    m_phase = 9;
+    m_counter = 0;
   }
 
   // Rate limiting: ensure minimum time between state changes
-  #if BIT_DELAY_US > 0
-  unsigned long now = micros();
-  if ((now - m_lastUpdateMicros) < BIT_DELAY_US) {
-    return false;  // Not enough time elapsed, try again later
+  if (m_bitDelayUs > 0) {
+    unsigned long now = micros();
+    if ((now - m_lastUpdateMicros) < m_bitDelayUs) {
+      return false;  // Not enough time elapsed, try again later
+    }
+    m_lastUpdateMicros = now;
   }
-  m_lastUpdateMicros = now;
-  #endif
 
-  // State machine for TM1637 protocol
-  // Protocol: START -> COMM1 -> STOP -> START -> COMM2+addr -> DATA bytes -> STOP -> START -> COMM3 -> STOP
+  // Sub-step 5 only exists in writeBit(): CLK is about to rise for the ACK
+  // clock and every chip should be holding its DIO LOW by now
+  if (m_counter == 5) {
+    for (uint8_t i = 0; i < m_count; i++) {
+      if (dioHigh(i)) m_nack |= (1 << i);
+    }
+  }
+
+  bool done = step();
+  writeLines();
+  if (done) m_missing = m_nack;
+  return done && !m_posted;
+}
 
+// Same sequence as TM1637Display32::step(), always as a full frame:
+// START -> COMM1 -> STOP -> START -> COMM2 -> 4 data bytes -> STOP -> START -> COMM3 -> STOP
+bool TM1637MultiDisplay::step() {
   switch (m_phase) {
-    case 0:  // Write COMM1 byte (0x40 = write data)
+    case 9:  // Start condition (both lines released first)
+      if (startCondition()) {
+        m_phase = 0;
+        m_counter = 0;
+        m_byte = TM1637_I2C_COMM1;
+      }
+      break;
+
+    case 0:  // Write COMM1 byte
       if (writeBit()) {
         m_phase = 1;
         m_counter = 0;
@@ -232,7 +3262,7 @@ bool TM1637Display32::update() {
       if (stopCondition()) {
         m_phase = 2;
         m_counter = 0;
-        m_byte = TM1637_I2C_COMM2 + (m_pos & 0x03);  // Address command
+        m_byte = TM1637_I2C_COMM2;  // Address 0
       }
       break;
 
@@ -248,22 +3278,13 @@ bool TM1637Display32::update() {
         m_phase = 4;
         m_counter = 0;
         m_currentSegment = 0;
-        if (m_length > 0) {
-          m_byte = m_segments[0];
-        }
       }
       break;
 
-    case 4:  // Write segment data bytes
+    case 4:  // Write segment data bytes, each display its own
       if (writeBit()) {
-        m_currentSegment++;
-        if (m_currentSegment >= m_length) {
-          m_phase = 5;
-          m_counter = 0;
-        } else {
-          m_byte = m_segments[m_currentSegment];
-          m_counter = 0;
-        }
+        m_counter = 0;
+        if (++m_currentSegment >= 4) m_phase = 5;
       }
       break;
 
@@ -271,7 +3292,7 @@ bool TM1637Display32::update() {
       if (stopCondition()) {
         m_phase = 6;
         m_counter = 0;
-        m_byte = TM1637_I2C_COMM3 + (m_brightness & 0x0f);  // Display control
+        m_byte = TM1637_I2C_COMM3 + (m_frameBrightness & 0x0f);  // Display control
       }
       break;
 
@@ -296,62 +3317,31 @@ bool TM1637Display32::update() {
       }
       break;
   }
-
   return false;
 }
 
-bool TM1637Display32::isIdle() const {
-  return m_counter == 255;
-}
-
-bool TM1637Display32::pump(unsigned long timeout_us) {
-  unsigned long start = micros();
-  while ((micros() - start) < timeout_us) {
-    if (update()) return true;  // idle or complete
-  }
-  return false;  // timed out, transmission still in progress
-}
-
-void TM1637Display32::setMinInterval(unsigned long interval_ms) {
-  m_minIntervalMillis = interval_ms;
-}
-
-bool TM1637Display32::isReadyForUpdate() {
-  if (!isIdle()) return false;
-  if (m_minIntervalMillis == 0) return true;
-  return (millis() - m_lastTransmissionMillis) >= m_minIntervalMillis;
-}
-
-// Write one bit of m_byte, returns true when byte complete (including ACK)
-bool TM1637Display32::writeBit() {
+bool TM1637MultiDisplay::writeBit() {
   switch (m_counter) {
     case 0:  // CLK LOW
-      pinMode(m_pinClk, OUTPUT);
-      digitalWrite(m_pinClk, LOW);  // Explicit LOW for ESP32
+      m_clkLow = true;
       m_counter++;
       break;
 
-    case 1:  // Set DIO to data bit
-      if (m_byte & 0x01) {
-        #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-        pinMode(m_pinDIO, INPUT_PULLUP);
-        #else
-        pinMode(m_pinDIO, INPUT);
-        #endif
+    case 1:  // Set every DIO to its data bit
+      if (m_phase == 4) {
+        uint16_t low = 0;
+        for (uint8_t i = 0; i < m_count; i++) {
+          if (!((m_frame[i][m_currentSegment] >> m_bit_count) & 0x01)) low |= (1 << i);
+        }
+        m_dioLow = low;
       } else {
-        pinMode(m_pinDIO, OUTPUT);
-        digitalWrite(m_pinDIO, LOW);  // Explicit LOW for ESP32
+        m_dioLow = ((m_byte >> m_bit_count) & 0x01) ? 0 : m_allDisplays;
       }
       m_counter++;
       break;
 
-    case 2:  // CLK HIGH (data is sampled by TM1637)
-      #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-      pinMode(m_pinClk, INPUT_PULLUP);
-      #else
-      pinMode(m_pinClk, INPUT);
-      #endif
-      m_byte >>= 1;
+    case 2:  // CLK HIGH (data is sampled by every TM1637)
+      m_clkLow = false;
       m_bit_count++;
       if (m_bit_count < 8) {
         m_counter = 0;  // Loop back for next bit
@@ -361,283 +3351,128 @@ bool TM1637Display32::writeBit() {
       break;
 
     case 3:  // CLK LOW for ACK
-      pinMode(m_pinClk, OUTPUT);
-      digitalWrite(m_pinClk, LOW);  // Explicit LOW for ESP32
+      m_clkLow = true;
       m_counter++;
       break;
 
-    case 4:  // Release DIO for ACK (we don't actually check it)
-      #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-      pinMode(m_pinDIO, INPUT_PULLUP);
-      #else
-      pinMode(m_pinDIO, INPUT);
-      #endif
+    case 4:  // Release DIO for ACK (sampled by update() before the next sub-step)
+      m_dioLow = 0;
       m_counter++;
       break;
 
     case 5:  // CLK HIGH for ACK
-      #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-      pinMode(m_pinClk, INPUT_PULLUP);
-      #else
-      pinMode(m_pinClk, INPUT);
-      #endif
+      m_clkLow = false;
       m_counter++;
       break;
 
     case 6:  // CLK LOW after ACK
-      pinMode(m_pinClk, OUTPUT);
-      digitalWrite(m_pinClk, LOW);  // Explicit LOW for ESP32
+      m_clkLow = true;
       m_bit_count = 0;
       return true;  // Byte complete
   }
   return false;
 }
 
-// Generate start condition, returns true when complete
-bool TM1637Display32::startCondition() {
+bool TM1637MultiDisplay::startCondition() {
   switch (m_counter) {
     case 0:  // Ensure CLK is HIGH
-      #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-      pinMode(m_pinClk, INPUT_PULLUP);
-      #else
-      pinMode(m_pinClk, INPUT);
-      #endif
+      m_clkLow = false;
       m_counter++;
       break;
 
     case 1:  // Ensure DIO is HIGH
-      #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-      pinMode(m_pinDIO, INPUT_PULLUP);
-      #else
-      pinMode(m_pinDIO, INPUT);
-      #endif
+      m_dioLow = 0;
       m_counter++;
       break;
 
     case 2:  // DIO goes LOW while CLK is HIGH (start condition)
-      pinMode(m_pinDIO, OUTPUT);
-      digitalWrite(m_pinDIO, LOW);  // Explicit LOW for ESP32
+      m_dioLow = m_allDisplays;
       return true;
   }
   return false;
 }
 
-// Generate stop condition, returns true when complete
-bool TM1637Display32::stopCondition() {
+bool TM1637MultiDisplay::stopCondition() {
   switch (m_counter) {
     case 0:  // CLK LOW
-      pinMode(m_pinClk, OUTPUT);
-      digitalWrite(m_pinClk, LOW);  // Explicit LOW for ESP32
+      m_clkLow = true;
       m_counter++;
       break;
 
     case 1:  // DIO LOW
-      pinMode(m_pinDIO, OUTPUT);
-      digitalWrite(m_pinDIO, LOW);  // Explicit LOW for ESP32
+      m_dioLow = m_allDisplays;
       m_counter++;
       break;
 
     case 2:  // CLK HIGH
-      #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-      pinMode(m_pinClk, INPUT_PULLUP);
-      #else
-      pinMode(m_pinClk, INPUT);
-      #endif
+      m_clkLow = false;
       m_counter++;
       break;
 
     case 3:  // DIO HIGH (stop condition: DIO rises while CLK is HIGH)
-      #if defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
-      pinMode(m_pinDIO, INPUT_PULLUP);
-      #else
-      pinMode(m_pinDIO, INPUT);
-      #endif
+      m_dioLow = 0;
       return true;
   }
   return false;
 }
 
-void TM1637Display32::clear() {
-  uint8_t data[] = { 0, 0, 0, 0 };
-  setSegments(data);
-}
-
-void TM1637Display32::showNumberDec(int num, bool leading_zero, uint8_t length, uint8_t pos) {
-  showNumberDecEx(num, 0, leading_zero, length, pos);
-}
-
-void TM1637Display32::showNumberDecEx(int num, uint8_t dots, bool leading_zero,
-                                    uint8_t length, uint8_t pos) {
-  showNumberBaseEx(num < 0 ? -10 : 10, num < 0 ? -num : num,
-                   dots, leading_zero, length, pos);
-}
-
-void TM1637Display32::showNumberHexEx(uint16_t num, uint8_t dots,
-                                    bool leading_zero, uint8_t length,
-                                    uint8_t pos) {
-  showNumberBaseEx(16, num, dots, leading_zero, length, pos);
+bool TM1637MultiDisplay::dioHigh(uint8_t display) const {
+  #if TM1637_FAST_GPIO
+  return (*m_dioIn[display] & m_dioMask[display]) != 0;
+  #else
+  return digitalRead(m_pinsDIO[display]) != LOW;
+  #endif
 }
 
-void TM1637Display32::showNumberBaseEx(int8_t base, uint16_t num, uint8_t dots,
-                                     bool leading_zero, uint8_t length,
-                                     uint8_t pos) {
-  bool negative = false;
-  if (base < 0) {
-    base = -base;
-    negative = true;
-  }
-  uint8_t digits[4];
-
-  if (num == 0 && !leading_zero) {
-    for (uint8_t i = 0; i < (length - 1); i++)
-      digits[i] = 0;
-    digits[length - 1] = encodeDigit(0);
-  } else {
-    for (int i = length - 1; i >= 0; --i) {
-      uint8_t digit = num % base;
-
-      if (digit == 0 && num == 0 && leading_zero == false)
-        digits[i] = 0;
-      else
-        digits[i] = encodeDigit(digit);
-
-      if (digit == 0 && num == 0 && negative) {
-        digits[i] = minusSegments;
-        negative = false;
+// Drive the pins to match m_clkLow/m_dioLow: one write per port for each
+// line kind that changed, pinMode() only for pins that have no port group
+void TM1637MultiDisplay::writeLines() {
+  if (m_clkLow != m_clkOut) {
+    #if TM1637_FAST_GPIO
+    for (uint8_t p = 0; p < m_ports; p++) {
+      if (m_portClk[p]) portWrite(p, m_clkLow ? m_portClk[p] : 0, m_clkLow ? 0 : m_portClk[p]);
+    }
+    if (m_clkSlow) {
+      for (uint8_t i = 0; i < m_clkCount; i++) {
+        if (m_clkPort[i] != 0xFF) continue;
+        if (m_clkLow) pinLow(m_pinsClk[i]);
+        else pinRelease(m_pinsClk[i]);
       }
-
-      num /= base;
     }
-
-    if (dots != 0) {
-      showDots(dots, digits);
+    #else
+    for (uint8_t i = 0; i < m_clkCount; i++) {
+      if (m_clkLow) pinLow(m_pinsClk[i]);
+      else pinRelease(m_pinsClk[i]);
     }
+    #endif
+    m_clkOut = m_clkLow;
   }
-  setSegments(digits, length, pos);
-}
-
-void TM1637Display32::showDots(uint8_t dots, uint8_t* digits) {
-  for (int i = 0; i < 4; ++i) {
-    digits[i] |= (dots & 0x80);
-    dots <<= 1;
-  }
-}
-
-uint8_t TM1637Display32::encodeDigit(uint8_t digit) {
-  return digitToSegment[digit & 0x0f];
-}
-
-uint8_t TM1637Display32::charToSeg(char c) {
-  if (c >= 'A' && c <= 'Z') return charToSegment[c - 'A'];
-  if (c >= 'a' && c <= 'z') return charToSegment[c - 'a'];
-  if (c >= '0' && c <= '9') return charToSegment[26 + (c - '0')];
-  if (c == ' ') return charToSegment[36];
-  if (c == '-') return charToSegment[37];
-  return 0x00;  // unknown character = blank
-}
-
-void TM1637Display32::displayText(const char* text, uint8_t pos) {
-  uint8_t segs[4] = {0, 0, 0, 0};
-  int maxLen = 4 - pos;
-  int textLen = strlen(text);
-  int len = (maxLen < textLen) ? maxLen : textLen;
-  for (int i = 0; i < len; i++) {
-    segs[pos + i] = charToSeg(text[i]);
-  }
-  setSegments(segs);
-}
-
-void TM1637Display32::displayCharAndNumber(char c, int number) {
-  uint8_t segs[4];
-  segs[0] = charToSeg(c);
 
-  // Format number for 3 digits (positions 1-3)
-  int absNum = abs(number);
-  if (absNum >= 10000) {
-    // 10000+: show as XX.X (e.g., 12300 -> "12.3")
-    absNum = absNum / 100;
-    segs[1] = encodeDigit((absNum / 100) % 10);
-    segs[2] = encodeDigit((absNum / 10) % 10) | SEG_DP;
-    segs[3] = encodeDigit(absNum % 10);
-  } else if (absNum >= 1000) {
-    // 1000-9999: show as X.XK (e.g., 1024 -> "1.0K", 5678 -> "5.6K")
-    absNum = absNum / 100;  // Get first two significant digits
-    segs[1] = encodeDigit((absNum / 10) % 10) | SEG_DP;
-    segs[2] = encodeDigit(absNum % 10);
-    segs[3] = charToSeg('K');
-  } else {
-    // 0-999: show as is, right-aligned, blank leading zeros
-    segs[1] = (absNum >= 100) ? encodeDigit((absNum / 100) % 10) : 0;
-    segs[2] = (absNum >= 10) ? encodeDigit((absNum / 10) % 10) : 0;
-    segs[3] = encodeDigit(absNum % 10);
-    // Handle negative
-    if (number < 0 && absNum < 100) {
-      segs[1] = SEG_G;  // Minus sign
+  uint16_t changed = m_dioLow ^ m_dioOut;
+  if (changed) {
+    #if TM1637_FAST_GPIO
+    tm1637_mask_t low[TM1637_MULTI_PORTS] = { 0 };
+    tm1637_mask_t release[TM1637_MULTI_PORTS] = { 0 };
+    #endif
+    for (uint8_t i = 0; i < m_count; i++) {
+      uint16_t bit = 1 << i;
+      if (!(changed & bit)) continue;
+      #if TM1637_FAST_GPIO
+      uint8_t p = m_dioPort[i];
+      if (p != 0xFF) {
+        if (m_dioLow & bit) low[p] |= m_dioMask[i];
+        else release[p] |= m_dioMask[i];
+        continue;
+      }
+      #endif
+      if (m_dioLow & bit) pinLow(m_pinsDIO[i]);
+      else pinRelease(m_pinsDIO[i]);
     }
+    #if TM1637_FAST_GPIO
+    for (uint8_t p = 0; p < m_ports; p++) {
+      if (low[p] | release[p]) portWrite(p, low[p], release[p]);
+    }
+    #endif
+    m_dioOut = m_dioLow;
   }
-  setSegments(segs, 4, 0);
-}
-
-void TM1637Display32::startScroll(const char* text, uint16_t interval_ms, uint8_t pad_spaces) {
-  // Build padded buffer: spaces + text + spaces
-  uint8_t textLen = strlen(text);
-  if (textLen > 24) textLen = 24;  // Limit text length
-
-  // Fill with leading spaces
-  uint8_t pos = 0;
-  for (uint8_t i = 0; i < pad_spaces && pos < 31; i++) {
-    m_scrollBuffer[pos++] = ' ';
-  }
-
-  // Copy text
-  for (uint8_t i = 0; i < textLen && pos < 31; i++) {
-    m_scrollBuffer[pos++] = text[i];
-  }
-
-  // Add trailing spaces
-  for (uint8_t i = 0; i < pad_spaces && pos < 31; i++) {
-    m_scrollBuffer[pos++] = ' ';
-  }
-
-  m_scrollBuffer[pos] = '\0';
-  m_scrollLength = pos;
-  m_scrollPos = 0;
-  m_scrollInterval = interval_ms;
-  m_scrollLastStep = millis();
-  m_scrollActive = true;
-
-  // Display first frame
-  displayText(m_scrollBuffer, 0);
-}
-
-bool TM1637Display32::updateScroll() {
-  if (!m_scrollActive) return true;
-
-  // Check if display is ready for next update
-  if (!isIdle()) return false;
-
-  // Check if it's time for next scroll step
-  unsigned long now = millis();
-  if ((now - m_scrollLastStep) < m_scrollInterval) return false;
-
-  m_scrollLastStep = now;
-  m_scrollPos++;
-
-  // Check if scroll is complete
-  if (m_scrollPos + 4 > m_scrollLength) {
-    m_scrollActive = false;
-    return true;
-  }
-
-  // Display current window
-  displayText(&m_scrollBuffer[m_scrollPos], 0);
-  return false;
-}
-
-bool TM1637Display32::isScrolling() const {
-  return m_scrollActive;
-}
-
-void TM1637Display32::stopScroll() {
-  m_scrollActive = false;
 }
@@ -14,6 +14,75 @@
 
 #include <inttypes.h>
 
+// RP2040/RP2350: optional PIO transport (see beginPIO())
+#if defined(ARDUINO_ARCH_RP2040)
+#define TM1637_HAS_PIO 1
+#include <hardware/pio.h>
+#include <hardware/sync.h>
+#else
+#define TM1637_HAS_PIO 0
+#endif
+
+// ESP32 with IDF 5 RMT driver (Arduino-ESP32 3.x): optional RMT playback (see beginRMT())
+#if (defined(ESP32) || defined(ESP_PLATFORM)) && defined(__has_include)
+#if __has_include(<driver/rmt_tx.h>)
+#define TM1637_HAS_RMT 1
+#include <driver/rmt_tx.h>
+#endif
+#endif
+#ifndef TM1637_HAS_RMT
+#define TM1637_HAS_RMT 0
+#endif
+
+// ESP32 esp_timer / RP2040 hardware alarm: optional self-scheduling driver (see beginTimer())
+#if defined(ESP32) || defined(ESP_PLATFORM)
+#define TM1637_HAS_TIMER 1
+#include <esp_timer.h>
+#elif defined(ARDUINO_ARCH_RP2040)
+#define TM1637_HAS_TIMER 1
+#include <hardware/timer.h>
+#else
+#define TM1637_HAS_TIMER 0
+#endif
+
+// Direct-register open-drain line toggling, cached in the constructor.
+// Build with TM1637_FAST_GPIO=0 to go through pinMode()/digitalWrite() instead.
+#ifndef TM1637_FAST_GPIO
+#if defined(__AVR__) || defined(ESP32) || defined(ARDUINO_ARCH_RP2040)
+#define TM1637_FAST_GPIO 1
+#else
+#define TM1637_FAST_GPIO 0
+#endif
+#endif
+
+#if TM1637_FAST_GPIO && defined(__AVR__)
+typedef volatile uint8_t tm1637_reg_t;   // DDRx
+typedef uint8_t tm1637_mask_t;
+#else
+typedef volatile uint32_t tm1637_reg_t;  // Output-enable set/clear registers
+typedef uint32_t tm1637_mask_t;
+#endif
+
+// Pin registers known at compile time for TM1637Display32T
+// (AVR: ATmega328P/168 with the Uno pin numbering)
+#if TM1637_FAST_GPIO && (defined(ESP32) || defined(ARDUINO_ARCH_RP2040) || \
+                         defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__))
+#define TM1637_CONST_GPIO 1
+#if defined(__AVR__)
+#include <avr/io.h>
+#elif defined(ARDUINO_ARCH_RP2040)
+#include <hardware/structs/sio.h>
+#else
+#include <soc/gpio_reg.h>
+#endif
+#else
+#define TM1637_CONST_GPIO 0
+#endif
+
+// Line state bits produced by the protocol state machine (1 = released/HIGH)
+#define TM1637_LINE_CLK     0x01
+#define TM1637_LINE_DIO     0x02
+
 #define SEG_A   0b00000001
 #define SEG_B   0b00000010
 #define SEG_C   0b00000100
@@ -23,12 +92,358 @@
 #define SEG_G   0b01000000
 #define SEG_DP  0b10000000
 
+//! Pre-encoded segment bytes of a string literal, see TM1637_TEXT()
+template<unsigned N>
+struct TM1637Segments {
+  uint8_t seg[N > 0 ? N : 1];
+  static constexpr uint8_t length = N;
+};
+
+// Font for constant evaluation: TM1637_TEXT() labels and the lookup tables
+// in the .cpp are built from it by the compiler. The tables are static
+// members, not namespace-scope arrays, so a file that reads them at run time
+// does not get a copy of its own (in RAM on AVR): there is one, defined in
+// the .cpp, and only linked in if a label is encoded at run time (at -O0,
+// say). The library's runtime lookups, TM1637Display32::encodeDigit() and
+// charToSeg(), read its PROGMEM tables instead.
+namespace tm1637_detail {
+
+struct Font {
+  static constexpr uint8_t digits[16] = {
+    // XGFEDCBA
+    0b00111111,    // 0
+    0b00000110,    // 1
+    0b01011011,    // 2
+    0b01001111,    // 3
+    0b01100110,    // 4
+    0b01101101,    // 5
+    0b01111101,    // 6
+    0b00000111,    // 7
+    0b01111111,    // 8
+    0b01101111,    // 9
+    0b01110111,    // A
+    0b01111100,    // b
+    0b00111001,    // C
+    0b01011110,    // d
+    0b01111001,    // E
+    0b01110001     // F
+  };
+
+  static constexpr uint8_t letters[26] = {
+    SEG_A | SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,         // A
+    SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,                 // b
+    SEG_A | SEG_D | SEG_E | SEG_F,                         // C
+    SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,                 // d
+    SEG_A | SEG_D | SEG_E | SEG_F | SEG_G,                 // E
+    SEG_A | SEG_E | SEG_F | SEG_G,                         // F
+    SEG_A | SEG_C | SEG_D | SEG_E | SEG_F,                 // G
+    SEG_C | SEG_E | SEG_F | SEG_G,                         // h
+    SEG_E | SEG_F,                                         // I
+    SEG_B | SEG_C | SEG_D | SEG_E,                         // J
+    SEG_C | SEG_E | SEG_F | SEG_G,                         // k (same as h)
+    SEG_D | SEG_E | SEG_F,                                 // L
+    SEG_A | SEG_C | SEG_E | SEG_G,                         // M (stylized)
+    SEG_C | SEG_E | SEG_G,                                 // n
+    SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,         // O
+    SEG_A | SEG_B | SEG_E | SEG_F | SEG_G,                 // P
+    SEG_A | SEG_B | SEG_C | SEG_F | SEG_G,                 // q
+    SEG_E | SEG_G,                                         // r
+    SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                 // S
+    SEG_D | SEG_E | SEG_F | SEG_G,                         // t
+    SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,                 // U
+    SEG_C | SEG_D | SEG_E,                                 // v
+    SEG_B | SEG_D | SEG_F | SEG_G,                         // W (stylized)
+    SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,                 // X (same as H)
+    SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,                 // y
+    SEG_A | SEG_B | SEG_D | SEG_E | SEG_G                  // Z
+  };
+};
+
+// Segment pattern of a hex digit (0-15)
+constexpr uint8_t encodeDigit(uint8_t digit) {
+  return Font::digits[digit & 0x0f];
+}
+
+// Segment pattern of a character (A-Z, a-z, 0-9, space, dash; anything else is blank)
+constexpr uint8_t encodeChar(char c) {
+  return (c >= 'A' && c <= 'Z') ? Font::letters[c - 'A'] :
+         (c >= 'a' && c <= 'z') ? Font::letters[c - 'a'] :
+         (c >= '0' && c <= '9') ? Font::digits[c - '0'] :
+         (c == '-') ? SEG_G : 0x00;
+}
+
+template<unsigned... I> struct Index {};
+template<unsigned N, unsigned... I>
+struct MakeIndex : MakeIndex<N - 1, N - 1, I...> {};
+template<unsigned... I>
+struct MakeIndex<0, I...> { typedef Index<I...> type; };
+
+template<unsigned N, unsigned... I>
+constexpr TM1637Segments<N - 1> encodeText(const char (&text)[N], Index<I...>) {
+  return TM1637Segments<N - 1>{{ encodeChar(text[I])... }};
+}
+
+template<unsigned N>
+constexpr TM1637Segments<N - 1> encodeText(const char (&text)[N]) {
+  return encodeText(text, typename MakeIndex<N - 1>::type());
+}
+
+}  // namespace tm1637_detail
+
+//! Encode a string literal at compile time, for showEncoded():
+//!   static constexpr auto LABEL = TM1637_TEXT("PLAY");
+//!   display.showEncoded(LABEL);
+#define TM1637_TEXT(text) (tm1637_detail::encodeText(text))
+
+// timeUntilNextStep()/service(): nothing scheduled until the next post
+#define TM1637_NOTHING_DUE  0xFFFFFFFFUL
+
+// Build profiles, to keep RAM per display down on AVR:
+//   TM1637_PROFILE_MINIMAL - setSegments() and the number/text helpers on up
+//                            to 4 digits (a 6-digit module shows its first
+//                            4), posted from one core; no post slots,
+//                            onPost(), tick pacing, ACK checks or retries,
+//                            animation/scroll engine, fades, key scanning,
+//                            setMinInterval() or watchdog
+//   TM1637_PROFILE_TEXT    - adds scrolling and play()
+//   TM1637_PROFILE_FULL    - everything (default)
+// Each TM1637_<feature> flag below can be set on its own as well. Set them
+// in the build flags, never above the #include in a sketch: the library
+// .cpp has to see the same ones (see TM1637Layout below).
+#define TM1637_PROFILE_MINIMAL  0
+#define TM1637_PROFILE_TEXT     1
+#define TM1637_PROFILE_FULL     2
+#ifndef TM1637_PROFILE
+#define TM1637_PROFILE TM1637_PROFILE_FULL
+#endif
+#ifndef TM1637_SCROLL
+#define TM1637_SCROLL   (TM1637_PROFILE >= TM1637_PROFILE_TEXT)  // play(), startScroll()
+#endif
+#ifndef TM1637_THROTTLE
+#define TM1637_THROTTLE (TM1637_PROFILE >= TM1637_PROFILE_FULL)  // setMinInterval()
+#endif
+#ifndef TM1637_WATCHDOG
+#define TM1637_WATCHDOG (TM1637_PROFILE >= TM1637_PROFILE_FULL)  // setTimeout()
+#endif
+#ifndef TM1637_RETRIES
+#define TM1637_RETRIES  (TM1637_PROFILE >= TM1637_PROFILE_FULL)  // setAckCheck(), setRetries(), calibrateBitDelay()
+#endif
+#ifndef TM1637_PACING
+#define TM1637_PACING   (TM1637_PROFILE >= TM1637_PROFILE_FULL)  // setTickPeriod(), setStepsPerTick()
+#endif
+#ifndef TM1637_HOOKS
+#define TM1637_HOOKS    (TM1637_PROFILE >= TM1637_PROFILE_FULL)  // onPost(), onAnimationDone(), TM1637DisplayTask
+#endif
+#ifndef TM1637_EFFECTS
+#define TM1637_EFFECTS  (TM1637_PROFILE >= TM1637_PROFILE_FULL)  // fadeTo(), blink()
+#endif
+#ifndef TM1637_KEYS
+#define TM1637_KEYS     (TM1637_PROFILE >= TM1637_PROFILE_FULL)  // setKeyScan()
+#endif
+
+// Grids the chip addresses (GRID1-GRID6); 4-digit modules wire up the first four
+#ifndef TM1637_MAX_DIGITS
+#if TM1637_PROFILE < TM1637_PROFILE_FULL
+#define TM1637_MAX_DIGITS   4
+#else
+#define TM1637_MAX_DIGITS   6
+#endif
+#endif
+
+// Characters startScroll(const char*) copies; longer text is cut there, as
+// before the scroll engine read text in place. startScrollBorrowed() and the
+// other sources are read in place and have no limit.
+#ifndef TM1637_SCROLL_COPY
+#define TM1637_SCROLL_COPY  24
+#endif
+
+// Key scan results (see getKeys()): 0-7 = K1 with SG1-SG8, 8-15 = K2 with SG1-SG8
+#define TM1637_NO_KEY       0xFF
+#define TM1637_KEY_EVENTS   8     // Queued press/release events (see readKeyEvent())
+
+// Posts on their way from setSegments() to the frame mailbox: one slot per
+// core, with a sequence count that is odd while it is being written. A post
+// masks interrupts on its core for the few stores it takes, so the tasks and
+// ISRs of a core take turns at its slot and no two cores share one; nobody
+// spins on a post. Whoever starts the next frame copies each slot between
+// two reads of its count, leaves one caught mid-write for later, and takes
+// the digits with the newest ticket (a counter every post takes a number from).
+// RP2040 is the exception: the M0+ has no atomic read-modify-write, so the
+// ticket and the frame claim take one SIO spinlock of the library's own, held
+// for a load and a store with interrupts masked; only the other core ever
+// waits on it (TM1637_SPINLOCK). The RP2350 builds under the same core but
+// its Cortex-M33 and Hazard3 cores have exclusive access, so it takes the
+// atomics like ESP32.
+// 0 leaves the slots out: a post writes the mailbox itself with interrupts
+// masked, so every post and update() must run on one core (any mix of
+// loop() and ISRs there). That is the default on single-core AVR and
+// Cortex-M, and in the MINIMAL and TEXT profiles everywhere.
+#ifndef TM1637_POST_SLOTS
+#if TM1637_PROFILE < TM1637_PROFILE_FULL || defined(__AVR__) || \
+    (defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M' && !defined(ARDUINO_ARCH_RP2040))
+#define TM1637_POST_SLOTS   0
+#elif defined(ESP32) || defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040)
+#define TM1637_POST_SLOTS   2
+#else
+#define TM1637_POST_SLOTS   1
+#endif
+#endif
+#if defined(ARDUINO_ARCH_RP2040) && defined(__ARM_ARCH_6M__)
+#define TM1637_SPINLOCK     1
+#else
+#define TM1637_SPINLOCK     0
+#endif
+#ifndef TM1637_CORE_ID
+#if defined(ARDUINO_ARCH_RP2040)
+#define TM1637_CORE_ID()    get_core_num()
+#elif defined(ESP32) || defined(ESP_PLATFORM)
+#define TM1637_CORE_ID()    xPortGetCoreID()
+#else
+#define TM1637_CORE_ID()    0
+#endif
+#endif
+#if defined(__AVR__)
+typedef uint8_t tm1637_post_t;     // Post tickets (compared across a short window)
+#else
+typedef uint32_t tm1637_post_t;    // Native width for the atomic increment
+#endif
+
+// RAM the post slots take on top of the profile's own state: a digit per
+// grid, the slot's count, ticket and brightness, and with several slots a
+// ticket per grid, padded to the ticket's alignment. make -C test/host
+// checks the host layout of each profile against limits that include it.
+// Build with TM1637_RAM_BUDGET=<bytes> to have the library .cpp check
+// sizeof(TM1637Display32) against a limit of your own on the target.
+#define TM1637_POST_ALIGN(n) (((n) + sizeof(tm1637_post_t) - 1) / sizeof(tm1637_post_t) * \
+                              sizeof(tm1637_post_t))
+#if TM1637_POST_SLOTS
+#define TM1637_POST_RAM     (TM1637_POST_SLOTS * (TM1637_POST_ALIGN(TM1637_POST_ALIGN( \
+                               (1 + (TM1637_POST_SLOTS > 1 ? TM1637_MAX_DIGITS : 0)) * sizeof(tm1637_post_t) + \
+                               TM1637_MAX_DIGITS + 2) + 1) + sizeof(tm1637_post_t)) + \
+                             (TM1637_POST_SLOTS > 1 ? sizeof(tm1637_post_t) : 0))
+#else
+#define TM1637_POST_RAM     0
+#endif
+
+// Result of the last transaction (see getError())
+#define TM1637_ERR_NONE     0
+#define TM1637_ERR_NOACK    1  // A byte went unanswered, retries used up
+#define TM1637_ERR_TIMEOUT  2  // Watchdog cut the transaction off
+
+// Build with TM1637_STATS=1 to collect TM1637Stats (costs a few cycles per update())
+#ifndef TM1637_STATS
+#define TM1637_STATS 0
+#endif
+
+#if TM1637_STATS
+//! Instrumentation counters, see TM1637Display32::getStats()
+struct TM1637Stats {
+  uint32_t framesStarted;     // Transactions launched, retries included
+  uint32_t framesCompleted;   // Transactions that reached the final STOP
+  uint32_t framesAborted;     // Cut off by a missing ACK
+  uint32_t framesTimedOut;    // Cut off by the 500ms watchdog
+  uint32_t framesSuperseded;  // Posts overwritten by a newer one before they were sent
+  uint32_t bytesSent;         // Command and data bytes of the frames started
+  uint32_t updateCalls;
+  uint32_t updateRateLimited; // update() calls that returned without a step
+  uint32_t updateSteps;       // update() calls that advanced the bit-bang state machine
+  uint32_t updateCyclesMin;   // CPU cycles inside update() (micros() * F_CPU/1e6 on AVR)
+  uint32_t updateCyclesAvg;
+  uint32_t updateCyclesMax;
+  uint32_t latencyUsMin;      // From the post to the final STOP of the frame carrying it
+  uint32_t latencyUsAvg;
+  uint32_t latencyUsMax;
+  uint32_t waveCacheHits;     // Transactions replayed from TM1637_WAVE_CACHE
+  uint32_t waveCacheMisses;   // Transactions rendered into it
+};
+#endif
+
+// Build with TM1637_TRACE=<entries> (power of two) to record every update() step
+#ifndef TM1637_TRACE
+#define TM1637_TRACE 0
+#endif
+
+// Build with TM1637_WAVE_CACHE=<entries> to replay repeated transactions from
+// pre-rendered edge lists, 2 bits per step (about 85 bytes of RAM per entry)
+#ifndef TM1637_WAVE_CACHE
+#define TM1637_WAVE_CACHE 0
+#endif
+
+#if TM1637_TRACE
+class Print;
+
+//! One recorded update() step, see TM1637Display32::dumpTrace()
+struct TM1637TraceEntry {
+  uint16_t deltaUs;  // Since the previous entry (saturates at 65535)
+  uint8_t phase;     // Protocol phase and sub-step the step ran in
+  uint8_t counter;
+  uint8_t lines;     // Line levels after the step: bit 0 = CLK, bit 1 = DIO
+};
+#endif
+
+//! Called after every setSegments()/invalidate() post (see onPost())
+typedef void (*TM1637PostHook)(void* ctx);
+
+//! Streams scroll text (see startScroll()): return the character at index,
+//! or '\0' once the text has ended. Indexes are asked for in order, once each.
+typedef char (*TM1637ScrollReader)(uint32_t index, void* ctx);
+
+//! One frame of an animation (see play())
+struct TM1637Frame {
+  uint8_t segments[4];   // Digits 0-3
+  uint16_t duration_ms;  // How long the frame stays up
+};
+
+// Animation modes (see play())
+#define TM1637_PLAY_ONCE      0  // Stop on the last frame
+#define TM1637_PLAY_LOOP      1  // 0, 1, .., n-1, 0, 1, ..
+#define TM1637_PLAY_PINGPONG  2  // 0, 1, .., n-1, n-2, .., 1, 0, 1, ..
+
+//! Called once an animation or scroll has run to its end (see onAnimationDone())
+typedef void (*TM1637AnimationHook)(void* ctx);
+
+class __FlashStringHelper;
+
+// The options that shape TM1637Display32, for TM1637Layout
+#define TM1637_LAYOUT ((unsigned long)(TM1637_SCROLL) | (unsigned long)(TM1637_THROTTLE) << 1 | \
+                       (unsigned long)(TM1637_WATCHDOG) << 2 | (unsigned long)(TM1637_RETRIES) << 3 | \
+                       (unsigned long)(TM1637_PACING) << 4 | (unsigned long)(TM1637_HOOKS) << 5 | \
+                       (unsigned long)(TM1637_EFFECTS) << 7 | \
+                       (unsigned long)(TM1637_KEYS) << 8 | (unsigned long)(TM1637_STATS != 0) << 9 | \
+                       (unsigned long)(TM1637_FAST_GPIO) << 10 | (unsigned long)(TM1637_HAS_PIO) << 11 | \
+                       (unsigned long)(TM1637_HAS_RMT) << 12 | (unsigned long)(TM1637_HAS_TIMER) << 13 | \
+                       (unsigned long)(TM1637_MAX_DIGITS) << 16 | (unsigned long)(TM1637_POST_SLOTS) << 20 | \
+                       (unsigned long)(TM1637_SCROLL ? TM1637_SCROLL_COPY : 0) << 24)
+
+//! Link-time layout check: every file that includes this header constructs
+//! one of these, and only the instance for the options the library .cpp was
+//! built with is defined. A sketch that sees other options (a TM1637_PROFILE
+//! defined above the #include, say) fails to link with an undefined
+//! TM1637Layout<...> constructor instead of running against a class whose
+//! members sit elsewhere.
+template <unsigned long LAYOUT, unsigned TRACE, unsigned WAVE_CACHE>
+struct TM1637Layout {
+  TM1637Layout();
+};
+static const TM1637Layout<TM1637_LAYOUT, TM1637_TRACE, TM1637_WAVE_CACHE> tm1637Layout;
+
 class TM1637Display32 {
 public:
   //! Initialize a TM1637Display object
   //! @param pinClk - Digital pin connected to CLK
   //! @param pinDIO - Digital pin connected to DIO
-  TM1637Display32(uint8_t pinClk, uint8_t pinDIO);
+  //! @param digits - Digits on the module (1-TM1637_MAX_DIGITS, default 4)
+  TM1637Display32(uint8_t pinClk, uint8_t pinDIO, uint8_t digits = 4);
+
+  //! Map display positions to the chip's grid addresses. Many 6-digit boards
+  //! wire the grids as {2, 1, 0, 5, 4, 3}; position 0 is the leftmost digit.
+  //! Frames still go out as one auto-increment burst over the grids.
+  //! Set it before the first frame (or call invalidate() and repaint).
+  //! @param order Grid address for each of the getDigitCount() positions
+  void setDigitOrder(const uint8_t order[]);
+
+  //! Digits on the module, as given to the constructor
+  uint8_t getDigitCount() const;
 
   //! Non-blocking update - call from timer ISR for consistent timing
   //! Progresses the display transmission one step at a time.
@@ -36,11 +451,52 @@ public:
   //! WARNING: Do not call from both ISR and main loop - use isIdle() in main loop
   bool update();
 
-  //! Check if display is idle (no transmission in progress)
+#if TM1637_HAS_PIO
+  //! Hand the bus over to a PIO state machine (RP2040/RP2350 only).
+  //! The PIO generates START/byte/ACK/STOP itself; setSegments() just pushes
+  //! the command and data bytes into the TX FIFO, so update() needs no ticks.
+  //! update(), isIdle() and pump() keep working and report the PIO status.
+  //! @param pio PIO block to use (pio0 or pio1)
+  //! @param step_us Microseconds per line transition (default 100 = BIT_DELAY_US)
+  //! @return true if a state machine and program space were available
+  bool beginPIO(PIO pio = pio0, uint16_t step_us = 100);
+#endif
+
+#if TM1637_HAS_RMT
+  //! Play transactions out through two RMT TX channels (ESP32, IDF 5 only).
+  //! setSegments() pre-renders the whole START/COMM1/.../STOP waveform and
+  //! hands it to the RMT hardware; a done interrupt marks the display idle.
+  //! update(), isIdle() and pump() keep working and report the RMT status.
+  //! @param step_us Microseconds per line transition (default 100 = BIT_DELAY_US)
+  //! @return true if both RMT channels could be allocated
+  bool beginRMT(uint16_t step_us = 100);
+#endif
+
+#if TM1637_HAS_TIMER
+  //! Drive update() from a one-shot hardware timer instead of a free-running ISR
+  //! (esp_timer on ESP32, a hardware alarm on RP2040/RP2350).
+  //! Starting a frame arms the timer, each tick re-arms it for the next step
+  //! and it stays disarmed once the transaction is done: no interrupts while idle.
+  //! On ESP32 the ticks run in the esp_timer task (ESP_TIMER_TASK), as the
+  //! library code is in flash and cannot run from an interrupt while the
+  //! flash cache is off; a step may start a little later than step_us.
+  //! Do not also call update() from your own timer ISR.
+  //! @param step_us Microseconds per line transition (default 100 = BIT_DELAY_US)
+  //! @return true if a timer could be allocated (false in PIO/RMT mode)
+  bool beginTimer(uint16_t step_us = 100);
+#endif
+
+  //! Check if display is idle (no transmission in progress or posted)
   //! Safe to call from main loop while ISR handles update()
   //! @return true if idle, false if busy
   bool isIdle() const;
 
+#if TM1637_HOOKS
+  //! Register a hook run (in the poster's context) after each frame post,
+  //! e.g. to wake a driver task. Pass NULL to remove it.
+  void onPost(TM1637PostHook hook, void* ctx = NULL);
+#endif
+
   //! Pump the state machine until transmission completes or timeout.
   //! Use this in loop()-based (non-ISR) projects to drive the display.
   //! Respects internal BIT_DELAY rate limiting between steps.
@@ -48,6 +504,144 @@ public:
   //! @return true if idle (complete or no transmission), false if timed out
   bool pump(unsigned long timeout_us = 25000);
 
+  //! Microseconds until update() next has work: the next step of the frame
+  //! in flight (bit delay, bus-reset gap), an animation/scroll frame, fade or
+  //! blink step, key scan, or the end of the setMinInterval() window.
+  //! 0 = due now. While PIO/RMT sends a frame it is checked every millisecond.
+  //! @return Microseconds, or TM1637_NOTHING_DUE if only a post can start work
+  uint32_t timeUntilNextStep() const;
+
+  //! Do all work that is due (update() until the next step lies in the
+  //! future or a frame has completed) and say how long the caller may sleep
+  //! or yield. For loop()-driven projects instead of pump()/updateScroll():
+  //!   uint32_t us = display.service();
+  //!   if (us > 2000) light_sleep(us);
+  //! A post from an ISR during the sleep needs a service() call to start.
+  //! @return Same as timeUntilNextStep()
+  uint32_t service();
+
+  //! Set the minimum time between update() steps (one line transition each).
+  //! Defaults to 100us on ESP32/RP2040 and 0 on AVR; a frame takes about
+  //! 220 steps. Does not change the PIO/RMT/timer step given to their begin.
+  //! @param us Microseconds per step (0 = as fast as update() is called)
+  void setBitDelay(uint16_t us);
+
+  //! Current minimum time between update() steps in microseconds
+  uint16_t getBitDelay() const;
+
+#if TM1637_PACING
+  //! Declare that update() is called every tick_us (e.g. 100 from a 10kHz
+  //! ISR). Pacing, the watchdog and the bus-reset gap then count calls
+  //! instead of reading millis()/micros() on every update(). beginTimer()
+  //! sets this to its step. Bit-bang transport; 0 = read the clocks (default).
+  //! @param tick_us Microseconds between update() calls, at least
+  void setTickPeriod(uint16_t tick_us);
+#endif
+
+#if TM1637_WATCHDOG
+  //! Abort a transaction that takes longer than this (default 500ms;
+  //! 0 = no watchdog). The bus is reset and the frame sent again, up to
+  //! setRetries() times (TM1637_RETRIES; without it, not at all).
+  void setTimeout(uint16_t ms);
+#endif
+
+#if TM1637_PACING
+  //! Run several steps in one update() call, to pay the ISR entry once per
+  //! batch instead of once per line transition (bit-bang transport).
+  //! setBitDelay() then spaces the calls, spin_us of busy-waiting spaces
+  //! the steps inside one; a batch stops early at the end of a frame. E.g. a
+  //! 1kHz tick with 28 steps sends a byte per interrupt. The TM1637 is rated
+  //! for about 2us per step: use spin_us = 0 only where update() itself is
+  //! that slow, and keep the ISR duration (steps * spin_us) in mind.
+  //! @param steps Steps per update() call (1 = one step, the default)
+  //! @param spin_us Microseconds between the steps of a batch
+  void setStepsPerTick(uint8_t steps, uint8_t spin_us = 0);
+
+  //! Steps run per update() call
+  uint8_t getStepsPerTick() const;
+#endif
+
+#if TM1637_RETRIES
+  //! Find the fastest step time at which the module still ACKs every byte
+  //! and settle on it plus a 50% margin. If it misses bytes at the current
+  //! delay, the delay is doubled (up to 800us) until it keeps up first; a
+  //! clean 0us stays 0. Blocking (three frames per candidate, about 300ms
+  //! from 100us); resends the current content.
+  //! Call before handing update() to an ISR/timer, bit-bang transport only.
+  //! @param min_us Fastest step time to try
+  //! @return The new bit delay, or the old one if the module never ACKed
+  uint16_t calibrateBitDelay(uint16_t min_us = 1);
+
+  //! Check the ACK of every byte (bit-bang transport; on by default).
+  //! A missing ACK aborts the transaction at once, resets the bus and
+  //! retries the newest posted frame up to setRetries() times.
+  void setAckCheck(bool enable);
+
+  //! Retries after a missing ACK or a watchdog timeout before giving up
+  //! with TM1637_ERR_NOACK / TM1637_ERR_TIMEOUT
+  //! @param retries 0-255 (default 2)
+  void setRetries(uint8_t retries);
+#endif
+
+  //! Result of the last finished transaction: TM1637_ERR_NONE, or
+  //! TM1637_ERR_NOACK / TM1637_ERR_TIMEOUT so the main loop can back off.
+  //! Without TM1637_RETRIES the ACK is not checked, so never NOACK.
+  //! After giving up nothing is resent until the next post (or invalidate()).
+  uint8_t getError() const;
+
+  //! Display frames that made it to the chip, counting up and wrapping at
+  //! 65535. Key scans, bus resets and attempts that were cut off or given
+  //! up do not count; a frame retried counts once. Take differences to
+  //! measure a frame rate. RMT frames count when both channels are through,
+  //! PIO frames at the first update() after the state machine ran them out.
+  uint16_t framesSent() const;
+
+#if TM1637_KEYS
+  //! Read the key matrix every interval_ms, in the gaps between display
+  //! transactions (bit-bang transport). A scan is START, 0x42, eight bits
+  //! clocked in, STOP: about 60 steps, during which isIdle() is false and
+  //! posted frames wait. Pass 0 to stop scanning.
+  //! @param interval_ms Milliseconds between scans (e.g. 10)
+  //! @param debounce Identical scans needed before a key change is reported
+  void setKeyScan(uint16_t interval_ms, uint8_t debounce = 2);
+
+  //! Milliseconds between key scans (0 = not scanning)
+  uint16_t getKeyScanInterval() const;
+
+  //! Debounced key held down: 0-7 = K1 row, 8-15 = K2 row (SG1-SG8),
+  //! TM1637_NO_KEY if none. The chip reports one key at a time.
+  uint8_t getKeys() const;
+
+  //! Take the oldest key event (up to TM1637_KEY_EVENTS are queued; newer
+  //! ones are dropped while it is full)
+  //! @param key Key that changed (see getKeys())
+  //! @param pressed true for a press, false for a release
+  //! @return false if there was no event
+  bool readKeyEvent(uint8_t& key, bool& pressed);
+#endif
+
+#if TM1637_STATS
+  //! Copy a consistent snapshot of the counters. Safe to call from the
+  //! main loop while update() runs in an ISR or on the other core.
+  void getStats(TM1637Stats& stats) const;
+
+  //! Zero the counters; applied by the next update() call
+  void resetStats();
+#endif
+
+#if TM1637_TRACE
+  //! Print the last TM1637_TRACE steps, oldest first, as CSV
+  //! (t_us,phase,counter,clk,dio) or as a VCD waveform for GTKWave/PulseView.
+  //! The counter is the sub-step, or in phase 15 (a replayed transaction,
+  //! see TM1637_WAVE_CACHE) the step within the transaction.
+  //! Recording pauses while dumping, so it is safe with update() in an ISR.
+  void dumpTrace(Print& out, bool vcd = false);
+
+  //! Drop all recorded steps
+  void clearTrace();
+#endif
+
+#if TM1637_THROTTLE
   //! Set minimum interval between display transmissions (for polled mode).
   //! Prevents rapid updates (e.g., from turning a dial) from blocking the main loop.
   //! @param interval_ms Minimum milliseconds between transmissions (0 = no throttle)
@@ -58,28 +652,71 @@ public:
   //! the last transmission started. Use instead of isIdle() when throttling.
   //! @return true if ready for new content
   bool isReadyForUpdate();
+#endif
 
-  //! Sets the brightness (takes effect on next setSegments call)
+  //! Sets the brightness (takes effect on next setSegments or sendBrightness call)
+  //! The display control command is only sent when the brightness changed.
+  //! Stops a fadeTo() or blink() in progress. Never waits: if an effect step
+  //! is running on another core (or in the code this call interrupted), that
+  //! step finishes first and the next update() applies the new brightness.
   //! @param brightness 0-7 (lowest to highest)
   //! @param on Turn display on or off
   void setBrightness(uint8_t brightness, bool on = true);
 
-  //! Display raw segment data
+  //! Send just the display control command for the current brightness,
+  //! without retransmitting segment data. No-op if the chip already has it.
+  void sendBrightness();
+
+  //! Display raw segment data. Posts the frame to a mailbox and returns in
+  //! constant time: it starts at once if the bus is free, otherwise update()
+  //! picks up the newest posted frame when the one in flight has finished.
+  //! Never blocks and never aborts a transmission; intermediate frames that
+  //! were overwritten before they could be sent are dropped.
+  //! Safe to call from several tasks, cores and ISRs at the same time, and
+  //! while update() runs in an ISR or on the other core: each call writes
+  //! only the post slot of its own core, with interrupts masked for a few
+  //! stores, and the newest post of each digit wins. The show/display
+  //! helpers post through it and are as safe.
+  //! Only digits that differ from what the chip already shows are sent (as one
+  //! auto-increment burst, or fixed-address writes for scattered digits);
+  //! if nothing changed the call returns without touching the bus.
   //! @param segments Array of segment values
-  //! @param length Number of digits (1-4)
-  //! @param pos Starting position (0-3)
+  //! @param length Number of digits (1-getDigitCount())
+  //! @param pos Starting position (0 = leftmost)
   void setSegments(const uint8_t segments[], uint8_t length = 4, uint8_t pos = 0);
 
+  //! Forget what the chip is showing, so the next frame resends every digit.
+  //! setSegments() only transmits digits that differ from the last frame
+  //! sent; call this after the module was power-cycled or replugged.
+  void invalidate();
+
   //! Clear the display
   void clear();
 
-  //! Display a decimal number
-  void showNumberDec(int num, bool leading_zero = false, uint8_t length = 4, uint8_t pos = 0);
+  //! Display a decimal number (full 32-bit range; a number wider than
+  //! length shows its low digits, as it always did: see showNumberDecChecked())
+  void showNumberDec(int32_t num, bool leading_zero = false, uint8_t length = 4, uint8_t pos = 0);
 
   //! Display a decimal number with dot control
-  void showNumberDecEx(int num, uint8_t dots = 0, bool leading_zero = false,
+  void showNumberDecEx(int32_t num, uint8_t dots = 0, bool leading_zero = false,
                        uint8_t length = 4, uint8_t pos = 0);
 
+  //! Like showNumberDecEx(), but a number wider than length, minus sign
+  //! included, shows a dash on every digit like showFixed() instead of a
+  //! wrong number
+  void showNumberDecChecked(int32_t num, uint8_t dots = 0, bool leading_zero = false,
+                            uint8_t length = 4, uint8_t pos = 0);
+
+  //! Display a fixed-point number: value / 10^decimals, e.g.
+  //! showFixed(-1234, 2) shows "-12.34" as "-12.3". Decimals that do not fit
+  //! are rounded away; if the integer part does not fit either, all digits
+  //! show a dash. Division free, cheap enough to call from an ISR.
+  //! @param value Number scaled by 10^decimals
+  //! @param decimals Digits after the decimal point (0-9)
+  //! @param length Number of digits to use (1-getDigitCount())
+  //! @param pos Starting position (0 = leftmost)
+  void showFixed(int32_t value, uint8_t decimals, uint8_t length = 4, uint8_t pos = 0);
+
   //! Display a hexadecimal number with dot control
   void showNumberHexEx(uint16_t num, uint8_t dots = 0, bool leading_zero = false,
                        uint8_t length = 4, uint8_t pos = 0);
@@ -88,74 +725,770 @@ public:
   uint8_t encodeDigit(uint8_t digit);
 
   //! Convert a character (A-Z, a-z, 0-9, space, dash) to segment pattern
+  //! (one table lookup; see TM1637_TEXT() for constant strings)
   uint8_t charToSeg(char c);
 
-  //! Display up to 4 characters starting at position (0-3)
+  //! Display text starting at position pos, as much as fits on the display
   void displayText(const char* text, uint8_t pos = 0);
 
+  //! Display pre-encoded segment bytes starting at position pos, blanking
+  //! the other digits like displayText()
+  //! @param segments Segment values, e.g. from TM1637_TEXT() or encodeDigit()
+  //! @param length Number of bytes in segments
+  //! @param pos Starting position (0 = leftmost)
+  void showEncoded(const uint8_t segments[], uint8_t length, uint8_t pos = 0);
+
+  //! Display a TM1637_TEXT() label starting at position pos
+  template<unsigned N>
+  void showEncoded(const TM1637Segments<N>& text, uint8_t pos = 0) {
+    showEncoded(text.seg, N, pos);
+  }
+
   //! Display a character at position 0 and a number at positions 1-3
   //! Numbers >= 1000 show with decimal point (e.g., 1230 -> "1.23")
   //! Numbers >= 10000 show as XX.X (e.g., 12300 -> "12.3")
   void displayCharAndNumber(char c, int number);
 
+#if TM1637_SCROLL
   //! Start scrolling text across the display
+  //! The text is copied, so a stack buffer or a temporary may go away once
+  //! this returns; only the first TM1637_SCROLL_COPY (24) characters are
+  //! kept. Characters are encoded once, as they enter the display.
   //! @param text The text to scroll (will be padded with spaces)
   //! @param interval_ms Milliseconds between scroll steps (default 300)
   //! @param pad_spaces Spaces to add at start and end for smooth scroll (default 4)
-  void startScroll(const char* text, uint16_t interval_ms = 300, uint8_t pad_spaces = 4);
+  //! @return false if an animation step was running elsewhere, see play()
+  bool startScroll(const char* text, uint16_t interval_ms = 300, uint8_t pad_spaces = 4);
+
+  //! Scroll caller-owned text read in place, with no copy and no length
+  //! limit: it must stay valid and unchanged until the scroll ends or is
+  //! stopped
+  bool startScrollBorrowed(const char* text, uint16_t interval_ms = 300,
+                           uint8_t pad_spaces = 4);
+
+  //! Scroll text kept in flash, e.g. startScroll(F("HELLO WORLD"))
+  bool startScroll(const __FlashStringHelper* text, uint16_t interval_ms = 300,
+                   uint8_t pad_spaces = 4);
 
-  //! Update scrolling - call from loop()
+  //! Scroll text produced on the fly
+  //! @param reader Called once per character as it enters the display
+  //! @param ctx Passed to reader
+  bool startScroll(TM1637ScrollReader reader, void* ctx, uint16_t interval_ms = 300,
+                   uint8_t pad_spaces = 4);
+
+  //! Scroll pre-encoded segment bytes (caller-owned, read in place)
+  //! @param segments Segment values, e.g. from TM1637_TEXT()
+  //! @param length Number of bytes in segments
+  bool startScrollEncoded(const uint8_t segments[], uint16_t length,
+                          uint16_t interval_ms = 300, uint8_t pad_spaces = 4);
+
+  //! Scroll a TM1637_TEXT() label; it must outlive the scroll (make it static)
+  template<unsigned N>
+  bool startScrollEncoded(const TM1637Segments<N>& text, uint16_t interval_ms = 300,
+                          uint8_t pad_spaces = 4) {
+    return startScrollEncoded(text.seg, N, interval_ms, pad_spaces);
+  }
+
+  //! Update scrolling - call from loop() if nothing else calls update()
+  //! (scroll steps are taken by update(), see play())
   //! @return true when scrolling is complete, false if still scrolling
   bool updateScroll();
 
   //! Check if currently scrolling
   bool isScrolling() const;
 
-  //! Stop scrolling immediately
+  //! Stop scrolling (see stopAnimation())
   void stopScroll();
 
+  //! Play a list of frames, each for its own duration. Frames are advanced
+  //! from update() (so from beginTimer(), your ISR or loop(), whichever runs
+  //! it) on a fixed schedule that does not drift with loop() load; with
+  //! beginTimer() the timer sleeps until the next frame is due. A frame is
+  //! never cut short before it reached the chip. Scrolling runs on the same
+  //! engine, so play() replaces a scroll and startScroll() replaces play().
+  //! The frames are read in place and must stay valid while playing. Do not
+  //! post anything else (setSegments() etc.) until the animation is over.
+  //! Frames cover positions 0-3; the digits of a 6-digit module beyond them
+  //! keep what they show.
+  //! Never waits for the engine: an update() stepping the animation on
+  //! another core, or in the code this call interrupted, makes it return
+  //! false without starting anything. Try again, e.g. from the next loop().
+  //! @param frames Frames to show
+  //! @param count Number of frames
+  //! @param mode TM1637_PLAY_ONCE, TM1637_PLAY_LOOP or TM1637_PLAY_PINGPONG
+  //! @return true if the animation was started
+  bool play(const TM1637Frame frames[], uint8_t count, uint8_t mode = TM1637_PLAY_ONCE);
+
+  //! Stop the running animation or scroll; the current frame stays up.
+  //! Never waits: a step already in progress elsewhere may still post its
+  //! frame, and the animation stops there.
+  void stopAnimation();
+
+  //! Check if an animation or scroll is running
+  bool isAnimating() const;
+
+#if TM1637_HOOKS
+  //! Register a hook run (from update()) when a TM1637_PLAY_ONCE animation or
+  //! a scroll ends by itself. Pass NULL to remove it.
+  void onAnimationDone(TM1637AnimationHook hook, void* ctx = NULL);
+#endif
+#endif
+
+#if TM1637_EFFECTS
+  //! Step the brightness to level, one level at a time spread over
+  //! duration_ms, from update(). Each step is a display control command on
+  //! its own (START, COMM3, STOP: about a third of a 4-digit frame); the
+  //! digits are not resent. Runs alongside play() and blink().
+  //! @param level Target brightness 0-7
+  //! @param duration_ms Time for the whole fade (0 = at once)
+  //! @param on false to switch the display off once the fade has finished
+  //! @return false if an effect step was running elsewhere, like play()
+  bool fadeTo(uint8_t level, uint16_t duration_ms, bool on = true);
+
+  //! Blink the whole display by switching it on and off with display
+  //! control commands from update(), keeping the brightness and the digits
+  //! @param on_ms Time on per blink
+  //! @param off_ms Time off per blink
+  //! @param count Number of blinks, 0 = until stopBlink()
+  //! @return false if an effect step was running elsewhere, like play()
+  bool blink(uint16_t on_ms, uint16_t off_ms, uint8_t count = 0);
+
+  //! Stop blinking, leaving the display on (never waits, like stopAnimation())
+  void stopBlink();
+
+  //! Check if a fadeTo() is still stepping
+  bool isFading() const;
+
+  //! Check if blink() is running
+  bool isBlinking() const;
+#endif
+
 protected:
-  void showDots(uint8_t dots, uint8_t* digits);
+  void showDots(uint8_t dots, uint8_t* digits, uint8_t length = 4);
   void showNumberBaseEx(int8_t base, uint16_t num, uint8_t dots = 0,
                         bool leading_zero = false, uint8_t length = 4, uint8_t pos = 0);
+  void showDigits(const uint8_t digits[], uint8_t count, bool negative, uint8_t dots,
+                  bool leading_zero, uint8_t length, uint8_t pos);
+  void showOverflow(uint8_t length, uint8_t pos);  // A dash on every digit
 
 private:
+  template <uint8_t, uint8_t, uint8_t> friend class TM1637Display32T;  // Steps the state machine itself
+
   // Pin configuration
   uint8_t m_pinClk;
   uint8_t m_pinDIO;
 
   // Display settings
   uint8_t m_brightness;
-  uint8_t m_segments[4];
-  uint8_t m_length;
-  uint8_t m_pos;
+  uint8_t m_digitCount;         // Digits on the module
+  uint8_t m_digitMap[TM1637_MAX_DIGITS];  // Grid address of each display position
+
+  // Who touches what:
+  //  - m_slots[n]: written by posts on core n only, with interrupts masked;
+  //    read, never written, by the claim holder.
+  //  - m_slotTaken, the frame mailbox (m_digits, m_digitsSet,
+  //    m_postedBrightness): the claim holder only (a producer in kick(), or
+  //    update()); without slots, posts too, with interrupts masked.
+  //  - The chip mirror (m_segments, m_segmentsValid, m_inflight,
+  //    m_chipBrightness, ...): the claim holder while the bus is free, which
+  //    fills it in launch(); then the transaction it started, until busy()
+  //    turns false.
+  //  - The state machine (m_phase, m_counter, ...): set up by launch() with
+  //    m_counter written last, then stepped by update() alone; volatile for
+  //    busy()/isIdle() on other cores and in ISRs.
+#if TM1637_POST_SLOTS
+  struct Post {
+    tm1637_post_t ticket;                      // Ticket of the newest post
+#if TM1637_POST_SLOTS > 1
+    tm1637_post_t tickets[TM1637_MAX_DIGITS];  // Ticket of the post that wrote each grid
+#endif
+    uint8_t digits[TM1637_MAX_DIGITS];         // By grid
+    uint8_t digitsSet;                         // Grids written since the slot was last taken
+    uint8_t brightness;                        // m_brightness as of the newest post
+  };
+  struct PostSlot {
+    Post post;
+    volatile uint8_t seq;                      // Odd while a post is being written
+  };
+  PostSlot m_slots[TM1637_POST_SLOTS];
+  tm1637_post_t m_slotTaken[TM1637_POST_SLOTS];  // Newest ticket taken from each slot
+#if TM1637_POST_SLOTS > 1
+  volatile tm1637_post_t m_postTicket;         // Last ticket handed out
+#endif
+#endif
+
+  // Frame mailbox
+  uint8_t m_digits[TM1637_MAX_DIGITS];    // Requested content, by grid
+  uint8_t m_digitsSet;          // Bitmask of digits that have requested content
+  uint8_t m_postedBrightness;   // m_brightness as of the latest post
+  volatile uint8_t m_resendRequests;  // Bumped by invalidate()
+  volatile bool m_posted;       // Posts or a resend not started yet
+  volatile uint8_t m_claimed;   // Frame start claimed by a producer or update()
+#if TM1637_HOOKS
+  TM1637PostHook m_postHook;
+  void* m_postHookCtx;
+#endif
+#if TM1637_SPINLOCK
+  spin_lock_t* m_postLock;      // The library's SIO spinlock: the claim and post tickets across cores
+#endif
+
+  // Chip mirror
+  uint8_t m_resendsDone;        // invalidate() requests applied
+  uint8_t m_segments[TM1637_MAX_DIGITS];  // Mirror of the chip's display RAM (incl. frame in flight)
+  uint8_t m_segmentsValid;      // Bitmask of m_segments entries known to match the chip
+  uint8_t m_inflight;           // Digits in the current transaction (+ 0x80: COMM3)
+  uint8_t m_chipBrightness;     // Brightness the chip has (incl. frame in flight, 0xFF = unknown)
+  bool m_fixedAddr;             // Current transaction uses fixed address mode
+  uint8_t m_length;             // Auto-increment: bytes from m_pos
+  uint8_t m_pos;                // Address of the (next) byte to send
 
   // State machine for non-blocking transmission
   // volatile: these are modified by ISR and read by main loop
   volatile uint8_t m_counter;        // Step within current phase
-  volatile uint8_t m_phase;          // Current protocol phase (0-8)
+  volatile uint8_t m_phase;          // Current protocol phase (0-8, 9 START, 10-11 bus reset, 12-14 key scan, 15 cached)
   volatile uint8_t m_byte;           // Current byte being transmitted
   volatile uint8_t m_bit_count;      // Bits transmitted of current byte
   volatile uint8_t m_currentSegment; // Current segment being transmitted
+  volatile uint8_t m_lines;          // Line levels requested by the state machine
+  uint8_t m_linesOut;                // Line levels currently driven on the pins
 
   // Timing for rate limiting and watchdog
-  unsigned long m_lastUpdateMicros;
-  unsigned long m_transmissionStartMillis;  // For timeout detection
-  unsigned long m_lastTransmissionMillis;   // For update throttling
-  unsigned long m_minIntervalMillis;        // Minimum ms between transmissions (0 = no throttle)
+  volatile uint8_t m_error;                 // TM1637_ERR_* of the last transaction
+#if TM1637_RETRIES
+  volatile uint8_t m_nacks;                 // Bytes without ACK since last cleared
+  bool m_ackCheck;                          // Abort on a missing ACK
+  uint8_t m_retries;                        // Retries per frame after a missing ACK
+  uint8_t m_retriesLeft;
+#endif
+  uint16_t m_bitDelayUs;                    // Minimum microseconds between update() steps
+  volatile uint16_t m_framesDone;           // Display frames through, see framesSent()
+  // Time stamps wrap at 32 bits like micros()/millis() on the boards, and
+  // are only ever compared as differences
+  uint32_t m_lastUpdateMicros;
+#if TM1637_RETRIES || TM1637_WATCHDOG
+  uint32_t m_gapStartMicros;                // Start of the idle gap after an aborted frame
+#endif
+#if TM1637_THROTTLE
+  uint32_t m_lastTransmissionMillis;        // For update throttling
+  uint32_t m_minIntervalMillis;             // Minimum ms between transmissions (0 = no throttle)
+#endif
+#if TM1637_WATCHDOG
+  uint32_t m_transmissionStartMillis;       // For timeout detection
+  uint16_t m_timeoutMs;                     // Watchdog limit per transaction (0 = off)
+#endif
+
+#if TM1637_KEYS
+  // Key scanning, run by update() between display transactions
+  uint16_t m_keyIntervalMs;                 // 0 = off
+  uint8_t m_keyDebounce;
+  uint32_t m_keyLastScan;                   // millis() of the last scan
+  volatile bool m_keyScanning;              // Transaction in flight is a key scan
+  uint8_t m_keyByte;                        // Bits clocked in so far
+  uint8_t m_keyCandidate;                   // Latest scan result, decoded
+  uint8_t m_keyCount;                       // Scans in a row with m_keyCandidate
+  volatile uint8_t m_key;                   // Debounced key
+  uint8_t m_keyEvents[TM1637_KEY_EVENTS];   // key | 0x80 for a press
+  volatile uint8_t m_keyHead;               // Written by update()
+  volatile uint8_t m_keyTail;               // Written by readKeyEvent()
+  void keyScan();                           // Start a scan if one is due
+  bool readBit();                           // Clock in one bit of m_keyByte
+  void keyScanned(uint8_t code);
+  void keyEvent(uint8_t event);
+#endif
+
+#if TM1637_PACING
+  // Tick-counted timing (setTickPeriod(), 0 = read the clocks)
+  uint16_t m_tickUs;
+  uint16_t m_paceTicks;                     // update() calls per step
+  uint16_t m_paceCount;                     // Calls left until the next step
+  uint16_t m_gapSteps;                      // Steps making up the bus-reset gap
+  uint16_t m_gapCount;
+  uint8_t m_stepsPerTick;                   // Steps per update() call
+  uint8_t m_stepSpinUs;                     // Busy-wait between the steps of a call
+#if TM1637_WATCHDOG
+  uint32_t m_watchdogTicks;                 // Calls allowed per transaction (0 = off)
+  uint32_t m_frameTicks;                    // Calls since the transaction started
+#endif
+  void tickTiming();                        // Recompute the tick counts
+#endif
+#if TM1637_WATCHDOG
+  void watchdogExpired();
+#endif
+
+#if TM1637_FAST_GPIO
+  // Output-enable registers and masks, index 0 = CLK, 1 = DIO
+  // (AVR sets and clears the one DDRx, so it keeps no m_oeClr)
+  tm1637_reg_t* m_oeSet[2];
+#if !defined(__AVR__)
+  tm1637_reg_t* m_oeClr[2];
+#endif
+  tm1637_mask_t m_mask[2];
+  const tm1637_reg_t* m_dioIn;     // Input register holding DIO, read with m_mask[DIO]
+#endif
+
+#if TM1637_STATS
+  // Instrumentation (written inside m_statsSeq odd/even brackets)
+  TM1637Stats m_stats;               // Avg fields unused, derived in getStats()
+  uint64_t m_statsCycles;            // Sum of update() cycles
+  uint32_t m_statsLatencyFrames;
+  uint64_t m_statsLatencyUs;         // Sum of latencies
+  volatile uint32_t m_statsSeq;
+  volatile bool m_statsReset;        // resetStats() requested
+  bool m_statsInFlight;              // A launched frame has not finished yet
+  bool m_statsUnsent;                // Mailbox holds a post not launched yet
+  unsigned long m_postMicros;        // Oldest post not launched yet
+  unsigned long m_frameMicros;       // Oldest post carried by the frame in flight
+  void statsFrameDone();
+  void statsClear();
+#endif
+
+#if TM1637_TRACE
+  // Step trace ring buffer
+  TM1637TraceEntry m_trace[TM1637_TRACE];
+  volatile uint16_t m_traceHead;     // Next slot to write
+  volatile uint16_t m_traceCount;
+  volatile bool m_traceFrozen;       // dumpTrace() is reading
+  unsigned long m_traceMicros;       // Time of the last entry
+  void traceStep(uint8_t phase, uint8_t counter);
+#endif
+
+#if TM1637_WAVE_CACHE
+  // Rendered transactions, least recently used gets replaced. Codes: 0 = no
+  // change, 1 = toggle CLK, 2 = toggle DIO, 3 = sample the ACK, then toggle CLK
+  struct WaveEntry {
+    uint8_t key[6 + TM1637_MAX_DIGITS];  // Transaction shape, brightness and data
+    uint8_t codes[70];                    // 4 steps per byte; a 6-digit frame is 273 steps
+    uint16_t steps;                       // 0 = empty
+    uint8_t used;                         // m_waveClock at the last use
+  };
+  WaveEntry m_wave[TM1637_WAVE_CACHE];
+  uint8_t m_waveClock;
+  const uint8_t* m_waveCodes;        // Replaying (phase 15), NULL otherwise
+  uint16_t m_waveStep;
+  uint16_t m_waveSteps;
+  void waveStart();                  // Replay (rendering first if needed) the prepared frame
+#endif
+
+  // Open-drain line control, line 0 = CLK, 1 = DIO
+  void lineLow(uint8_t line);      // Drive the line LOW
+  void lineRelease(uint8_t line);  // Release the line to the pull-up (HIGH)
+  bool dioHigh() const;            // Sample DIO (LOW during ACK = chip answered)
 
   // Internal protocol helpers
+  void kick();              // Start the posted frame if the bus is free
+  void queuePost(const uint8_t segments[], uint8_t length, uint8_t pos);
+#if TM1637_POST_SLOTS
+  tm1637_post_t takeTicket();  // Next post ticket, caller has masked interrupts
+#endif
+  void notifyPost();        // Run the onPost() hook, if any
+  void drainPosts();        // Take the slots' new posts into the mailbox, caller holds the claim
+  void applyPost(const uint8_t digits[], uint8_t digitsSet, uint8_t brightness);
+  uint8_t mapDigits(const uint8_t segments[], uint8_t length, uint8_t pos,
+                    uint8_t digits[]) const;  // Positions to grids, returns the grid mask
+  void launch();            // Snapshot the mailbox and start its transaction
+  bool tryClaim();          // Non-blocking claim on starting a frame
+  void releaseClaim();
+  bool busy() const;        // Transmission in progress on the active transport
+  uint8_t dirtyDigits(const uint8_t digits[], uint8_t digitsSet) const;  // Not yet on the chip
+  bool prepareFrame(const uint8_t digits[], uint8_t digitsSet, uint8_t brightness);
+  void startFrame();        // Load the first phase and byte of the transaction
+  void abortFrame();        // Forget chip state touched by an unfinished frame
+#if TM1637_RETRIES
+  void busError();          // Missing ACK: abort, reset the bus, retry or give up
+#endif
+  bool tick();              // update() minus the instrumentation
+  bool stepDue();           // Watchdog and rate limit when reading the clocks, true when a step is due
+  bool stepsDone();         // Last step of a transaction taken: count it, chain a newer post
+  void pumpPace() const;    // Between the update() calls of pump()
+  static unsigned long nowMicros();  // micros(), for TM1637Display32T::pump()
+  // Bit-banging a frame (or the bus reset) one step per update() call, with
+  // nothing recorded: TM1637Display32T::update() can take the step inline
+  bool plainStep() const {
+#if TM1637_STATS || TM1637_TRACE
+    return false;
+#else
+#if TM1637_HAS_PIO
+    if (m_pioActive) return false;
+#endif
+#if TM1637_HAS_RMT
+    if (m_rmtActive) return false;
+#endif
+#if TM1637_PACING
+    if (m_tickUs || m_stepsPerTick != 1) return false;
+#endif
+    return m_counter != 255 && m_phase < 12;  // Not idle, scanning keys or replaying (15)
+#endif
+  }
+  uint8_t dataCommand() const { return m_fixedAddr ? 0x44 : 0x40; }  // COMM1
+  bool step();              // Advance protocol one sub-step, returns true when done
+  void writeLines();        // Apply m_lines to the pins
   bool writeBit();          // Write one bit, returns true when byte complete
   bool startCondition();    // Generate start, returns true when complete
   bool stopCondition();     // Generate stop, returns true when complete
 
+#if TM1637_HAS_PIO
+  // PIO transport state (only used after a successful beginPIO())
+  bool m_pioActive;
+  PIO m_pio;
+  uint m_pioSm;
+  uint m_pioOffset;
+  bool m_pioFrame;          // Handed to the state machine, not counted in m_framesDone yet
+
+  bool pioIdle() const;     // TX FIFO drained and state machine parked at entry
+  void pioCount();          // Count the frame the state machine finished; caller holds the claim
+  void pioWriteFrame();     // Push COMM1 / COMM2+data / COMM3 blocks to the FIFO
+#endif
+
+#if TM1637_HAS_RMT
+  // RMT playback state (only used after a successful beginRMT())
+  bool m_rmtActive;
+  rmt_channel_handle_t m_rmtClk;
+  rmt_channel_handle_t m_rmtDIO;
+  rmt_encoder_handle_t m_rmtEncoderClk;
+  rmt_encoder_handle_t m_rmtEncoderDIO;
+  rmt_sync_manager_handle_t m_rmtSync;  // NULL if the target has no TX sync
+  rmt_symbol_word_t* m_rmtSymbols;      // Rendered CLK symbols, then DIO symbols
+  uint16_t m_rmtStepTicks;              // 1 tick = 1us
+  volatile uint8_t m_rmtPending;        // Channels still transmitting
+
+  void rmtRelease();                    // Free whatever beginRMT() allocated
+  void rmtAbort();                      // Stop both channels mid-transmission
+  void rmtWriteFrame(bool reset);       // Render and start one transaction
+  static bool rmtDone(rmt_channel_handle_t channel,
+                      const rmt_tx_done_event_data_t* edata, void* ctx);
+#endif
+
+#if TM1637_HAS_TIMER
+  // One-shot timer driver state (only used after a successful beginTimer())
+  bool m_timerActive;
+  uint16_t m_timerStepUs;
+#if defined(ARDUINO_ARCH_RP2040)
+  int m_timerAlarm;
+  static void timerAlarm(uint alarm);
+#else
+  esp_timer_handle_t m_timer;
+  static void timerTick(void* arg);
+#endif
+  void timerArm();                      // Schedule the next update() one step out
+  void timerArmIn(uint32_t delay_us);
+  void timerIdle();                     // Sleep until the next animation frame, fade step or scan
+#endif
+  uint32_t idleWait() const;            // Microseconds to the next scheduled idle-path work
+  void postSegments(const uint8_t segments[], uint8_t length, uint8_t pos);  // Caller holds the claim
+
+#if TM1637_SCROLL
+  // Animation engine state, owned by whoever holds the claim
+  enum AnimSource { ANIM_NONE, ANIM_FRAMES, ANIM_SCROLL };
+  enum AnimStep { ANIM_WAIT, ANIM_POSTED, ANIM_DONE };
+  volatile uint8_t m_animSource;  // AnimSource
+  // What the animation reads; one runs at a time, so play() frames and the
+  // scroll source share the pointer
+  union {
+    const TM1637Frame* frames;    // ANIM_FRAMES
+    const char* text;             // SCROLL_TEXT, SCROLL_FLASH
+    const uint8_t* segments;      // SCROLL_SEGMENTS
+    TM1637ScrollReader reader;    // SCROLL_READER
+  } m_animData;
+  uint8_t m_animCount;
+  uint8_t m_animIndex;            // Frame on the display
+  uint8_t m_animMode;             // TM1637_PLAY_*
+  int8_t m_animDir;               // Ping-pong direction
+  uint32_t m_animStart;           // micros() the current frame was due
+  uint32_t m_animDurationUs;      // Of the current frame
+#if TM1637_HOOKS
+  TM1637AnimationHook m_animHook;
+  void* m_animHookCtx;
+#endif
+  volatile uint8_t m_animStops;   // Bumped by stopAnimation()
+  uint8_t m_animStopsDone;        // stopAnimation() requests applied
+  void animate();                 // Advance the animation if the next frame is due
+  uint8_t animStep();             // AnimStep
+  bool animClaim();               // Claim for a new animation, false if one is stepping
+  void animBegin(uint8_t source, uint32_t duration_us);
+  void animStops();               // Caller holds the claim
+#endif
+
+#if TM1637_EFFECTS
+  // Brightness effects, stepped by update() with display control commands only
+  volatile bool m_fading;
+  uint8_t m_fadeTarget;
+  bool m_fadeOn;                  // Display on after the last step
+  uint32_t m_fadeStart;           // micros() the current step was due
+  uint32_t m_fadeIntervalUs;      // Per level
+  volatile bool m_blinking;
+  bool m_blinkOff;                // In the off half of a blink
+  uint8_t m_blinkLeft;            // Blinks to go, 0 = endless
+  uint32_t m_blinkStart;          // micros() the current half was due
+  uint32_t m_blinkOnUs;
+  uint32_t m_blinkOffUs;
+  volatile uint8_t m_effectStops;       // Bumped by setBrightness() during an effect
+  uint8_t m_effectStopsDone;
+  volatile uint8_t m_brightnessRequest; // Brightness that goes with it
+  volatile uint8_t m_blinkStops;        // Bumped by stopBlink()
+  uint8_t m_blinkStopsDone;
+  bool effectStops();             // Caller holds the claim; true if it posted
+  void brightnessEffects();       // Step the fade and blink if due
+  bool brightnessStep();          // Caller holds the claim; true if it posted
+#endif
+
+#if TM1637_SCROLL
   // Scrolling state
-  char m_scrollBuffer[32];        // Buffer for padded scroll text (max 24 chars + padding)
-  uint8_t m_scrollLength;         // Length of text in buffer
-  uint8_t m_scrollPos;            // Current scroll position
-  uint16_t m_scrollInterval;      // Ms between scroll steps
-  unsigned long m_scrollLastStep; // Time of last scroll step
-  bool m_scrollActive;            // Whether scrolling is active
+  enum ScrollSource { SCROLL_TEXT, SCROLL_FLASH, SCROLL_READER, SCROLL_SEGMENTS };
+  void* m_scrollCtx;              // Reader context
+  uint32_t m_scrollIndex;         // Next source position to read
+  uint16_t m_scrollLength;        // Source length (SCROLL_SEGMENTS only)
+  uint8_t m_scrollKind;           // ScrollSource
+  uint8_t m_scrollLead;           // Leading blanks still to shift in
+  uint8_t m_scrollTrail;          // Trailing blanks still to shift in
+  bool m_scrollEnd;               // Source exhausted
+  uint8_t m_scrollWindow[TM1637_MAX_DIGITS];  // Segments on the display, encoded once each
+  char m_scrollCopy[TM1637_SCROLL_COPY + 1];  // startScroll(const char*) text
+  volatile bool m_scrollActive;   // Whether scrolling is active
+  void beginScroll(uint8_t kind, uint16_t interval_ms, uint8_t pad_spaces);
+  bool scrollNext(uint8_t& segments);  // Next byte to shift in, false at the end
+#endif
+};
+
+#if TM1637_CONST_GPIO
+//! Open-drain toggling of a pin known at compile time: one store to the
+//! output-enable set/clear register (ESP32/RP2040) or one sbi/cbi (AVR),
+//! and one load to sample it
+template <uint8_t PIN>
+struct TM1637Pin {
+#if defined(__AVR__)
+  static_assert(PIN < 20, "TM1637Pin: Uno pin numbers 0-19 only");
+  static const uint8_t BIT = PIN < 8 ? PIN : PIN < 14 ? PIN - 8 : PIN - 14;
+  static inline void low() {
+    if (PIN < 8) DDRD |= (1 << BIT);
+    else if (PIN < 14) DDRB |= (1 << BIT);
+    else DDRC |= (1 << BIT);
+  }
+  static inline void release() {
+    if (PIN < 8) DDRD &= ~(1 << BIT);
+    else if (PIN < 14) DDRB &= ~(1 << BIT);
+    else DDRC &= ~(1 << BIT);
+  }
+  static inline bool high() {
+    return ((PIN < 8 ? PIND : PIN < 14 ? PINB : PINC) & (1 << BIT)) != 0;
+  }
+#elif defined(ARDUINO_ARCH_RP2040)
+  static inline void low() { sio_hw->gpio_oe_set = 1u << PIN; }
+  static inline void release() { sio_hw->gpio_oe_clr = 1u << PIN; }
+  static inline bool high() { return (sio_hw->gpio_in & (1u << PIN)) != 0; }
+#else
+#ifdef GPIO_ENABLE1_W1TS_REG
+  static inline void low() {
+    *(volatile uint32_t*)(PIN >= 32 ? GPIO_ENABLE1_W1TS_REG : GPIO_ENABLE_W1TS_REG) = 1u << (PIN & 31);
+  }
+  static inline void release() {
+    *(volatile uint32_t*)(PIN >= 32 ? GPIO_ENABLE1_W1TC_REG : GPIO_ENABLE_W1TC_REG) = 1u << (PIN & 31);
+  }
+  static inline bool high() {
+    return (*(volatile uint32_t*)(PIN >= 32 ? GPIO_IN1_REG : GPIO_IN_REG) & (1u << (PIN & 31))) != 0;
+  }
+#else
+  static_assert(PIN < 32, "TM1637Pin: GPIO 0-31 only on this target");
+  static inline void low() { *(volatile uint32_t*)GPIO_ENABLE_W1TS_REG = 1u << PIN; }
+  static inline void release() { *(volatile uint32_t*)GPIO_ENABLE_W1TC_REG = 1u << PIN; }
+  static inline bool high() { return (*(volatile uint32_t*)GPIO_IN_REG & (1u << PIN)) != 0; }
+#endif
+#endif
+};
+#endif
+
+//! TM1637Display32 with CLK and DIO fixed at compile time. update() takes
+//! the steps of a frame itself: the step comes from the shared state
+//! machine, and each line toggle and the ACK sample are inlined TM1637Pin<>
+//! accesses, with no call or lookup between the state machine and the pin.
+//! Frame boundaries, key scans, tick pacing, several steps per call, the
+//! wave cache, STATS/TRACE builds and the PIO/RMT transports go through
+//! TM1637Display32::update(). Where the registers are not known at compile
+//! time (TM1637_CONST_GPIO=0) the lines go through the same calls as in
+//! TM1637Display32, so the bus sees the same waveform in every profile.
+//! beginTimer() and TM1637DisplayTask drive the display through
+//! TM1637Display32::update(); call update() or pump() on this class to
+//! get the inline steps.
+//! @tparam CLK - Digital pin connected to CLK
+//! @tparam DIO - Digital pin connected to DIO
+//! @tparam DIGITS - Digits on the module (default 4)
+template <uint8_t CLK, uint8_t DIO, uint8_t DIGITS = 4>
+class TM1637Display32T : public TM1637Display32 {
+public:
+  TM1637Display32T() : TM1637Display32(CLK, DIO, DIGITS) {}
+
+  //! TM1637Display32::update(), with the steps of a frame inlined
+  bool update() {
+    if (!plainStep()) return TM1637Display32::update();
+    if (!stepDue()) return false;
+#if TM1637_RETRIES
+    // ACK clock about to rise, as in TM1637Display32::tick()
+    if (m_counter == 5 && dioHighT()) {
+      m_nacks++;
+      if (m_ackCheck) {
+        busError();
+        return false;
+      }
+    }
+#endif
+    bool done = step();
+#if TM1637_CONST_GPIO
+    uint8_t changed = m_lines ^ m_linesOut;
+    if (changed & TM1637_LINE_CLK) {
+      if (m_lines & TM1637_LINE_CLK) TM1637Pin<CLK>::release();
+      else TM1637Pin<CLK>::low();
+    }
+    if (changed & TM1637_LINE_DIO) {
+      if (m_lines & TM1637_LINE_DIO) TM1637Pin<DIO>::release();
+      else TM1637Pin<DIO>::low();
+    }
+    m_linesOut = m_lines;
+#else
+    writeLines();
+#endif
+    return done && stepsDone();
+  }
+
+  //! TM1637Display32::pump() around the update() above
+  bool pump(unsigned long timeout_us = 25000) {
+    unsigned long start = nowMicros();
+    while ((nowMicros() - start) < timeout_us) {
+      if (update()) return true;
+      pumpPace();
+    }
+    return false;
+  }
+
+private:
+#if TM1637_RETRIES
+  bool dioHighT() const {
+#if TM1637_CONST_GPIO
+    return TM1637Pin<DIO>::high();
+#else
+    return dioHigh();
+#endif
+  }
+#endif
+};
+
+// Displays and GPIO ports per TM1637MultiDisplay
+#ifndef TM1637_MULTI_MAX
+#define TM1637_MULTI_MAX 8
+#endif
+#define TM1637_MULTI_PORTS 4
+
+//! Several 4-digit modules clocked in lockstep by a single state machine.
+//! Either all modules share one CLK pin and each has its own DIO, or every
+//! module has its own CLK and DIO. Each step drives or releases all lines
+//! of a kind with one masked output-enable write per GPIO port, so N
+//! displays refresh in the time of one. Every frame carries all four digits
+//! and the display control command for every module, so the frames of all
+//! modules have the same shape and only their data bits differ.
+class TM1637MultiDisplay {
+public:
+  //! Shared CLK, one DIO per display
+  //! @param pinClk - Digital pin connected to CLK of all displays
+  //! @param pinsDIO - Digital pins connected to DIO, one per display
+  //! @param count - Number of displays (up to TM1637_MULTI_MAX)
+  TM1637MultiDisplay(uint8_t pinClk, const uint8_t pinsDIO[], uint8_t count);
+
+  //! One CLK and one DIO per display
+  TM1637MultiDisplay(const uint8_t pinsClk[], const uint8_t pinsDIO[], uint8_t count);
+
+  //! Non-blocking update, same contract as TM1637Display32::update()
+  //! @return true if no transmission in progress (idle), false if busy
+  bool update();
+
+  //! Check if all displays are idle (no transmission in progress or posted)
+  bool isIdle() const;
+
+  //! Call update() until idle or timeout (one multi frame takes as long as a single one)
+  bool pump(unsigned long timeout_us = 25000);
+
+  //! Number of displays driven
+  uint8_t count() const { return m_count; }
+
+  //! Set the brightness of all displays; takes effect with the next frame
+  void setBrightness(uint8_t brightness, bool on = true);
+
+  //! Post raw segment data for one display; returns at once and the
+  //! next frame (started by update()) carries it, latest value wins.
+  //! Safe to call from the main loop while update() runs in an ISR.
+  //! @param display Display index (0 to count()-1)
+  void setSegments(uint8_t display, const uint8_t segments[], uint8_t length = 4, uint8_t pos = 0);
+
+  //! Blank one display
+  void clear(uint8_t display);
+
+  //! Set the minimum time between update() steps, as for TM1637Display32
+  //! @param us Microseconds per step (0 = as fast as update() is called)
+  void setBitDelay(uint16_t us) { m_bitDelayUs = us; }
+
+  //! Current minimum time between update() steps in microseconds
+  uint16_t getBitDelay() const { return m_bitDelayUs; }
+
+  //! Displays that left a byte of the last finished frame unacknowledged,
+  //! as a bitmask of display indices (0 = every module answered). Each DIO
+  //! is read once per byte, at the ACK clock. Frames are not retried: the
+  //! next post resends everything anyway.
+  uint16_t getMissing() const { return m_missing; }
+
+private:
+  uint8_t m_count;
+  uint8_t m_pinsClk[TM1637_MULTI_MAX];
+  uint8_t m_clkCount;                       // 1 (shared) or m_count
+  uint8_t m_pinsDIO[TM1637_MULTI_MAX];
+  uint16_t m_allDisplays;                   // Bitmask of all display indices
+
+  // Frame mailbox, written by setSegments() and read when update() starts a frame
+  uint8_t m_digits[TM1637_MULTI_MAX][4];
+  uint8_t m_brightness;
+  volatile uint8_t m_seq;                   // Odd while a post is being written
+  volatile bool m_posted;
+
+  // Snapshot being transmitted
+  uint8_t m_frame[TM1637_MULTI_MAX][4];
+  uint8_t m_frameBrightness;
+
+  // State machine, same phases and sub-steps as TM1637Display32
+  volatile uint8_t m_counter;               // Sub-step (255 = idle)
+  volatile uint8_t m_phase;
+  uint8_t m_byte;                           // Command byte common to all displays
+  uint8_t m_bit_count;
+  uint8_t m_currentSegment;
+  uint16_t m_bitDelayUs;                    // Minimum microseconds between update() steps
+  unsigned long m_lastUpdateMicros;
+  uint16_t m_nack;                          // Displays without ACK in the frame in flight
+  volatile uint16_t m_missing;              // Same for the last finished frame
+
+  // Line state (1 = low/driven, unlike m_lines in TM1637Display32)
+  bool m_clkLow;
+  bool m_clkOut;
+  uint16_t m_dioLow;                        // Bitmask of displays with DIO driven LOW
+  uint16_t m_dioOut;
+
+#if TM1637_FAST_GPIO
+  // Output-enable register pairs; displays whose pins don't fit fall back to pinMode()
+  uint8_t m_ports;
+  tm1637_reg_t* m_portSet[TM1637_MULTI_PORTS];
+  tm1637_reg_t* m_portClr[TM1637_MULTI_PORTS];
+  tm1637_mask_t m_portClk[TM1637_MULTI_PORTS];  // CLK pins on each port
+  uint8_t m_clkPort[TM1637_MULTI_MAX];      // Port index, 0xFF = pinMode() fallback
+  uint8_t m_dioPort[TM1637_MULTI_MAX];
+  tm1637_mask_t m_dioMask[TM1637_MULTI_MAX];
+  const tm1637_reg_t* m_dioIn[TM1637_MULTI_MAX];  // Input register holding each DIO
+  bool m_clkSlow;                           // Some CLK pin needs pinMode()
+  uint8_t portFor(uint8_t pin, tm1637_mask_t* mask);
+  void portWrite(uint8_t port, tm1637_mask_t low, tm1637_mask_t release);
+#endif
+
+  void init(const uint8_t pinsClk[], uint8_t clkCount, const uint8_t pinsDIO[], uint8_t count);
+  bool startFrame();        // Snapshot the mailbox, false if a post is in progress
+  bool step();              // Advance one sub-step, true when the frame is done
+  bool writeBit();
+  bool startCondition();
+  bool stopCondition();
+  void writeLines();        // Apply m_clkLow/m_dioLow with masked writes
+  bool dioHigh(uint8_t display) const;  // Sample one module's DIO
 };
 
 #endif // __TM1637DISPLAY32__
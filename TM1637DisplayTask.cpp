@@ -0,0 +1,128 @@
+//  TM1637DisplayTask - FreeRTOS task driver for TM1637Display32 (ESP32)
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+
+#include <TM1637DisplayTask.h>
+
+#if (defined(ESP32) || defined(ESP_PLATFORM)) && TM1637_HOOKS
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_rom_sys.h>
+
+// Microsecond timestamp that is never 0 (0 marks "nothing posted")
+static inline uint32_t taskNowUs() {
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  return now ? now : 1;
+}
+
+TM1637DisplayTask::TM1637DisplayTask(TM1637Display32& display)
+  : m_display(display) {
+  m_task = NULL;
+  m_stepUs = 100;
+  m_postedAt = 0;
+  m_worstLatency = 0;
+  m_fps = 0;
+  m_windowFrames = 0;
+  m_windowStart = 0;
+}
+
+bool TM1637DisplayTask::begin(BaseType_t core, UBaseType_t priority, uint16_t step_us) {
+  if (m_task != NULL) return true;
+  m_stepUs = step_us;
+  m_display.setTickPeriod(step_us);  // pace() spaces the calls already
+  m_windowStart = taskNowUs();
+  m_windowFrames = m_display.framesSent();
+  if (xTaskCreatePinnedToCore(taskEntry, "tm1637", 2048, this, priority,
+                              &m_task, core) != pdPASS) {
+    m_task = NULL;
+    return false;
+  }
+  m_display.onPost(posted, this);
+  xTaskNotifyGive(m_task);  // Pick up anything posted before begin()
+  return true;
+}
+
+uint16_t TM1637DisplayTask::framesPerSecond() const {
+  if ((taskNowUs() - m_windowStart) >= 2000000) return 0;  // Nothing sent lately
+  return m_fps;
+}
+
+uint32_t TM1637DisplayTask::worstLatencyUs() const {
+  return m_worstLatency;
+}
+
+void TM1637DisplayTask::resetStats() {
+  m_worstLatency = 0;
+}
+
+void TM1637DisplayTask::posted(void* ctx) {
+  TM1637DisplayTask* driver = (TM1637DisplayTask*)ctx;
+
+  // Latency runs from the first post the task has not finished yet
+  uint32_t expected = 0;
+  __atomic_compare_exchange_n(&driver->m_postedAt, &expected, taskNowUs(),
+                              false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+  if (xPortInIsrContext()) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(driver->m_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  } else {
+    xTaskNotifyGive(driver->m_task);
+  }
+}
+
+void TM1637DisplayTask::taskEntry(void* arg) {
+  ((TM1637DisplayTask*)arg)->run();
+}
+
+void TM1637DisplayTask::pace(TickType_t& lastWake) {
+  TickType_t ticks = pdMS_TO_TICKS(m_stepUs / 1000);
+  if (ticks == 0) {
+    esp_rom_delay_us(m_stepUs);  // Below tick resolution: spin on this core
+  } else {
+    vTaskDelayUntil(&lastWake, ticks);
+  }
+}
+
+void TM1637DisplayTask::run() {
+  for (;;) {
+    // Animation frames, fade steps and key scans come from update(): sleep
+    // until the next one is due, or until a post wakes us
+    uint32_t wait = m_display.timeUntilNextStep();
+    TickType_t timeout = portMAX_DELAY;
+    if (wait != TM1637_NOTHING_DUE) {
+      timeout = pdMS_TO_TICKS((wait + 999) / 1000);
+      if (timeout == 0) timeout = 1;
+    }
+    ulTaskNotifyTake(pdTRUE, timeout);
+
+    // Several posts may have been coalesced into the frame already sent
+    if (m_display.update()) {
+      m_postedAt = 0;
+      continue;
+    }
+
+    TickType_t lastWake = xTaskGetTickCount();
+    do {
+      pace(lastWake);
+    } while (!m_display.update());
+
+    uint32_t now = taskNowUs();
+    uint32_t postedAt = __atomic_exchange_n(&m_postedAt, 0, __ATOMIC_RELAXED);
+    if (postedAt != 0 && (now - postedAt) > m_worstLatency) m_worstLatency = now - postedAt;
+
+    // Counted by the display: a wake that only scanned the keys sent no frame
+    if ((now - m_windowStart) >= 1000000) {
+      uint16_t sent = m_display.framesSent();
+      m_fps = (uint16_t)(sent - m_windowFrames);
+      m_windowFrames = sent;
+      m_windowStart = now;
+    }
+  }
+}
+
+#endif
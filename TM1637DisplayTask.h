@@ -0,0 +1,68 @@
+//  TM1637DisplayTask - FreeRTOS task driver for TM1637Display32 (ESP32)
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+
+#ifndef __TM1637DISPLAYTASK__
+#define __TM1637DISPLAYTASK__
+
+#include <TM1637Display32.h>
+
+#if (defined(ESP32) || defined(ESP_PLATFORM)) && TM1637_HOOKS
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+//! Runs update() for one display from a FreeRTOS task pinned to a core.
+//! The task sleeps on a task notification and only wakes when a frame is
+//! posted with setSegments() (or any of the show/display helpers), so the
+//! display costs nothing on the other core and nothing at all while idle.
+//! While a play()/startScroll() animation, a fadeTo() or a blink() runs,
+//! or setKeyScan() is on, it also wakes when timeUntilNextStep() says the
+//! next step is due.
+//! Do not call update() yourself or use beginTimer() alongside it.
+class TM1637DisplayTask {
+public:
+  //! @param display Display to drive (the task only calls its update())
+  TM1637DisplayTask(TM1637Display32& display);
+
+  //! Create the driver task.
+  //! Steps shorter than a FreeRTOS tick are paced with esp_rom_delay_us(),
+  //! which keeps the task's core busy for the length of a frame (about 20ms
+  //! at 100us); longer steps sleep with vTaskDelayUntil().
+  //! @param core Core to pin the task to (default 0, away from loop() on core 1)
+  //! @param priority FreeRTOS task priority
+  //! @param step_us Microseconds per line transition (default 100 = BIT_DELAY_US)
+  //! @return true if the task was created
+  bool begin(BaseType_t core = 0, UBaseType_t priority = 2, uint16_t step_us = 100);
+
+  //! Display frames completed during the last full second (key scans and
+  //! wake-ups that sent nothing do not count, see framesSent())
+  uint16_t framesPerSecond() const;
+
+  //! Worst time from a post to the display being idle again, in microseconds
+  uint32_t worstLatencyUs() const;
+
+  //! Clear the worst-case latency
+  void resetStats();
+
+private:
+  TM1637Display32& m_display;
+  TaskHandle_t m_task;
+  uint16_t m_stepUs;
+
+  volatile uint32_t m_postedAt;   // Time of the earliest unsent post (0 = none)
+  volatile uint32_t m_worstLatency;
+  volatile uint16_t m_fps;
+  uint16_t m_windowFrames;        // m_display.framesSent() at m_windowStart
+  volatile uint32_t m_windowStart;
+
+  void run();
+  void pace(TickType_t& lastWake);  // Wait one step
+  static void taskEntry(void* arg);
+  static void posted(void* ctx);    // TM1637Display32 post hook
+};
+
+#endif
+#endif // __TM1637DISPLAYTASK__
@@ -0,0 +1,100 @@
+/*
+ * TM1637Display32 Animation Example
+ *
+ * Plays frame lists from the same timer that sends the frames, so a
+ * spinner, a blink and a marquee keep exact frame times however busy
+ * loop() is.
+ *
+ * Architecture:
+ *   - beginTimer() drives update() (ESP32 / RP2040); on other boards call
+ *     display.update() from loop() or your own timer ISR instead
+ *   - play() advances the frames from update(), onAnimationDone() tells
+ *     the sketch when a one-shot animation or a scroll has finished
+ *   - loop() only picks the next animation
+ *   - Needs TM1637_PROFILE_FULL, the default: the smaller profiles leave
+ *     play() or onAnimationDone() out
+ *
+ * Connections:
+ *   CLK -> GPIO 18 (or your chosen pin)
+ *   DIO -> GPIO 21 (or your chosen pin)
+ *   VCC -> 3.3V or 5V
+ *   GND -> GND
+ */
+
+#include <TM1637Display32.h>
+
+#if !TM1637_SCROLL || !TM1637_HOOKS
+#error "This example needs TM1637_PROFILE_FULL (-DTM1637_PROFILE=2 in the build flags)"
+#endif
+
+// Pin definitions - adjust for your board
+#define CLK 18
+#define DIO 21
+
+TM1637Display32 display(CLK, DIO);
+
+// A segment running around the outside of the display
+const TM1637Frame spinner[] = {
+  {{SEG_A, SEG_A, SEG_A, SEG_A}, 80},
+  {{0, 0, 0, SEG_A | SEG_B}, 80},
+  {{0, 0, 0, SEG_B | SEG_C}, 80},
+  {{0, 0, 0, SEG_C | SEG_D}, 80},
+  {{SEG_D, SEG_D, SEG_D, SEG_D}, 80},
+  {{SEG_D | SEG_E, 0, 0, 0}, 80},
+  {{SEG_E | SEG_F, 0, 0, 0}, 80},
+  {{SEG_F | SEG_A, 0, 0, 0}, 80},
+};
+
+// "donE" blinking three times
+#define DONE_ON  {{SEG_B | SEG_C | SEG_D | SEG_E | SEG_G, SEG_C | SEG_D | SEG_E | SEG_G, \
+                   SEG_C | SEG_E | SEG_G, SEG_A | SEG_D | SEG_E | SEG_F | SEG_G}, 300}
+#define DONE_OFF {{0, 0, 0, 0}, 200}
+const TM1637Frame blinkDone[] = { DONE_ON, DONE_OFF, DONE_ON, DONE_OFF, DONE_ON };
+
+volatile bool finished = false;
+
+void animationDone(void* ctx) {
+  finished = true;  // Runs from update(): keep it short
+}
+
+uint8_t scene = 0;
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.println("TM1637 Animation Example");
+
+  display.setBrightness(3);
+  display.onAnimationDone(animationDone);
+#if TM1637_HAS_TIMER
+  display.beginTimer();
+#endif
+  display.play(spinner, sizeof(spinner) / sizeof(spinner[0]), TM1637_PLAY_LOOP);
+}
+
+void loop() {
+#if !TM1637_HAS_TIMER
+  display.update();
+#endif
+
+  static unsigned long sceneStart = 0;
+  unsigned long now = millis();
+
+  // The spinner loops forever: move on after 3 seconds
+  if (scene == 0 && now - sceneStart > 3000) {
+    scene = 1;
+    display.play(blinkDone, sizeof(blinkDone) / sizeof(blinkDone[0]));
+  }
+
+  if (finished) {
+    finished = false;
+    if (scene == 1) {
+      scene = 2;
+      display.startScroll("HELLO ANIMAtIOn", 250);
+    } else {
+      scene = 0;
+      sceneStart = now;
+      display.play(spinner, sizeof(spinner) / sizeof(spinner[0]), TM1637_PLAY_LOOP);
+    }
+  }
+}
@@ -0,0 +1,121 @@
+/*
+ * TM1637Display32 Benchmark
+ *
+ * Measures the library on the target itself and prints one line per
+ * result, so runs can be compared after a library change:
+ *   - update() steps per frame for a full repaint, one changed digit and
+ *     an unchanged frame (dirty-digit diffing; a byte is 28 steps)
+ *   - frame time at the default bit delay and with no delay at all
+ *   - CPU time of the formatting helpers (showNumberDecEx, showNumberHexEx,
+ *     which goes through showNumberBaseEx, and displayText) including
+ *     posting the frame, and the time per scroll step including its frame
+ *     (not in TM1637_PROFILE_MINIMAL)
+ *   - with TM1637_STATS=1 in the build flags: bytes on the wire and
+ *     cycles per update()
+ *
+ * Connections:
+ *   CLK -> GPIO 18 (or your chosen pin)
+ *   DIO -> GPIO 21 (or your chosen pin)
+ *   VCC -> 3.3V or 5V
+ *   GND -> GND
+ */
+
+#include <TM1637Display32.h>
+
+// Pin definitions - adjust for your board
+#define CLK 18
+#define DIO 21
+
+#define ROUNDS 100
+
+TM1637Display32 display(CLK, DIO);
+
+// Steps the state machine takes to send whatever is posted
+unsigned long countSteps() {
+  unsigned long steps = 0;
+  uint16_t bitDelay = display.getBitDelay();
+  display.setBitDelay(0);  // Every update() call is one step
+  while (!display.update()) steps++;
+  display.setBitDelay(bitDelay);
+  return steps;
+}
+
+// Microseconds to send whatever is posted at the current bit delay
+unsigned long frameTime() {
+  unsigned long start = micros();
+  while (!display.update()) {}
+  return micros() - start;
+}
+
+void report(const char* what, unsigned long value, const char* unit) {
+  Serial.print(what);
+  Serial.print(": ");
+  Serial.print(value);
+  Serial.println(unit);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.println("TM1637Display32 Benchmark");
+
+  display.setBrightness(3);
+  display.showNumberDec(1234);
+  while (!display.update()) {}
+
+  // Bus work, from the library's own state machine
+  display.invalidate();
+  report("steps/full frame", countSteps(), "");
+  display.showNumberDec(1235);
+  report("steps/one digit", countSteps(), "");
+  display.showNumberDec(1235);
+  report("steps/unchanged", countSteps(), "");
+
+  display.invalidate();
+  report("us/full frame", frameTime(), "us");
+  uint16_t bitDelay = display.getBitDelay();
+  display.setBitDelay(0);
+  display.invalidate();
+  report("us/full frame, no delay", frameTime(), "us");
+  display.setBitDelay(bitDelay);
+
+  // Formatting cost: the frame is only posted, isIdle() is not waited for
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < ROUNDS; i++) display.showNumberDecEx(i * 97, 0, false);
+  report("us/showNumberDecEx", (micros() - start) / ROUNDS, "us");  // -> decimalDigits(), showDigits()
+  while (!display.update()) {}
+
+  start = micros();
+  for (uint16_t i = 0; i < ROUNDS; i++) display.showNumberHexEx(i * 97, 0, false);
+  report("us/showNumberHexEx", (micros() - start) / ROUNDS, "us");  // -> showNumberBaseEx()
+  while (!display.update()) {}
+
+  start = micros();
+  for (uint16_t i = 0; i < ROUNDS; i++) display.displayText(i & 1 ? "HELO" : "PLAY");
+  report("us/displayText", (micros() - start) / ROUNDS, "us");
+  while (!display.update()) {}
+
+#if TM1637_SCROLL
+  // Scroll steps are taken by update(); at a zero interval each one follows
+  // the previous frame at once, so this is encode + post + bus time per step
+  const char* scrollText = "SCROLL BENCH";
+  // 4 pad spaces each side: one window per position, then the step that ends it
+  uint16_t scrollSteps = (strlen(scrollText) + 2 * 4 - 4 + 1) + 1;
+  start = micros();
+  display.startScroll(scrollText, 0);
+  while (display.isScrolling()) display.update();
+  report("us/scroll step", (micros() - start) / scrollSteps, "us");
+#endif
+
+#if TM1637_STATS
+  TM1637Stats stats;
+  display.getStats(stats);
+  report("frames", stats.framesCompleted, "");
+  report("bytes on the wire", stats.bytesSent, "");
+  report("cycles/update() avg", stats.updateCyclesAvg, "");
+  report("cycles/update() max", stats.updateCyclesMax, "");
+#endif
+}
+
+void loop() {
+}
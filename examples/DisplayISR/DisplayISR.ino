@@ -7,7 +7,8 @@
  *
  * Architecture:
  *   - Timer ISR calls display.update() every 100us for consistent bit-banging
- *   - Main loop uses display.isIdle() to check when ready for new content
+ *   - Main loop posts new content whenever it likes; the ISR sends the
+ *     newest posted frame as soon as the one in flight has finished
  *   - No blocking, no race conditions
  *
  * Connections:
@@ -28,11 +29,6 @@ TM1637Display32 display(CLK, DIO);
 // Hardware timer for display updates
 hw_timer_t *displayTimer = NULL;
 
-// Display state
-bool displayUpdatePending = false;
-char pendingChar = ' ';
-int pendingValue = 0;
-
 // Demo state
 int counter = 0;
 unsigned long lastUpdateTime = 0;
@@ -78,16 +74,8 @@ void loop() {
     counter++;
     if (counter > 9999) counter = 0;
 
-    // Queue display update - don't block!
-    pendingChar = 'C';
-    pendingValue = counter;
-    displayUpdatePending = true;
-  }
-
-  // Start new display content only when idle (ISR handles the transmission)
-  if (displayUpdatePending && display.isIdle()) {
-    display.displayCharAndNumber(pendingChar, pendingValue);
-    displayUpdatePending = false;
+    // Post display update - returns at once, latest value wins
+    display.displayCharAndNumber('C', counter);
   }
 
   // Your other loop tasks go here...
@@ -0,0 +1,64 @@
+/*
+ * TM1637Display32 FreeRTOS Task Example for ESP32
+ *
+ * Runs the display from a task pinned to core 0, so loop() on core 1
+ * (your audio or control code) never spends a cycle on it.
+ *
+ * Architecture:
+ *   - TM1637DisplayTask sleeps until a frame is posted, then drives update()
+ *   - Main loop posts new content whenever it likes; latest value wins
+ *   - Frames/sec and worst-case post-to-idle latency are printed every second
+ *
+ * Connections:
+ *   CLK -> GPIO 18 (or your chosen pin)
+ *   DIO -> GPIO 21 (or your chosen pin)
+ *   VCC -> 3.3V or 5V
+ *   GND -> GND
+ */
+
+#include <TM1637Display32.h>
+#include <TM1637DisplayTask.h>
+
+// Pin definitions - adjust for your board
+#define CLK 18
+#define DIO 21
+
+TM1637Display32 display(CLK, DIO);
+TM1637DisplayTask displayTask(display);
+
+// Demo state
+int counter = 0;
+unsigned long lastUpdateTime = 0;
+unsigned long lastReportTime = 0;
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.println("TM1637 Task Example");
+
+  display.setBrightness(3);
+  displayTask.begin(0);  // Pin the display task to core 0
+  display.displayText("tASK");
+  delay(1000);
+}
+
+void loop() {
+  unsigned long now = millis();
+
+  // Post display update - returns at once, the task sends it
+  if (now - lastUpdateTime > 50) {  // Every 50ms
+    lastUpdateTime = now;
+    counter++;
+    if (counter > 9999) counter = 0;
+    display.showNumberDec(counter);
+  }
+
+  if (now - lastReportTime > 1000) {
+    lastReportTime = now;
+    Serial.print("fps: ");
+    Serial.print(displayTask.framesPerSecond());
+    Serial.print("  worst latency: ");
+    Serial.print(displayTask.worstLatencyUs());
+    Serial.println("us");
+  }
+}
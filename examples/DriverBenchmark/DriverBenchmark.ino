@@ -0,0 +1,267 @@
+/*
+ * TM1637Display32 Driver Mode Benchmark
+ *
+ * Measures what one way of driving the display costs the rest of the
+ * firmware, so the cheapest mode can be picked per product. Set MODE below,
+ * flash, and the sketch prints one row of the comparison table; run it once
+ * per mode and paste the rows under one header:
+ *   - fps: frames sent per second when a new frame is posted as soon as
+ *     the last one has gone out
+ *   - cpu%: share of loop() work lost to the display (posting, update(),
+ *     the ISR or the task), against a run with the display left alone
+ *   - post ns / post max us: cost of one setSegments() call while the mode
+ *     runs (RMT renders the waveform here, the bit-bang modes may start it)
+ *   - jitter us: how much later a 1kHz periodic job in loop() runs at
+ *     worst, on top of its lateness without the display
+ *
+ * Modes:
+ *   MODE_PUMP     pump() after each post, from loop() (blocks for a frame)
+ *   MODE_SERVICE  service() on every pass through loop()
+ *   MODE_ISR      update() from a 10kHz timer ISR (ESP32, RP2040)
+ *   MODE_BATCH    28 steps per update() from a 1kHz timer ISR (ESP32, RP2040)
+ *   MODE_TIMER    beginTimer(): one-shot timer, no interrupts while idle
+ *   MODE_PIO      beginPIO() (RP2040/RP2350)
+ *   MODE_RMT      beginRMT() (ESP32, IDF 5)
+ *   MODE_TASK     TM1637DisplayTask, pinned to loop()'s core so its time
+ *                 is counted (ESP32)
+ *
+ * Connections:
+ *   CLK -> GPIO 18 (or your chosen pin)
+ *   DIO -> GPIO 21 (or your chosen pin)
+ *   VCC -> 3.3V or 5V
+ *   GND -> GND
+ */
+
+#include <TM1637Display32.h>
+
+#define MODE_PUMP     0
+#define MODE_SERVICE  1
+#define MODE_ISR      2
+#define MODE_BATCH    3
+#define MODE_TIMER    4
+#define MODE_PIO      5
+#define MODE_RMT      6
+#define MODE_TASK     7
+
+// Mode to measure - change and re-flash for each row
+#define MODE MODE_PUMP
+
+// Pin definitions - adjust for your board
+#define CLK 18
+#define DIO 21
+
+#define WINDOW_US  2000000UL  // Length of each measurement
+#define PERIOD_US  1000UL     // The competing periodic job
+#define ROUNDS     1000       // setSegments() calls timed
+
+TM1637Display32 display(CLK, DIO);
+
+#if MODE == MODE_TASK
+#if !defined(ESP32)
+#error "MODE_TASK needs an ESP32"
+#endif
+#include <TM1637DisplayTask.h>
+TM1637DisplayTask displayTask(display);
+#endif
+
+#if MODE == MODE_ISR || MODE == MODE_BATCH
+#if MODE == MODE_ISR
+#define TICK_US 100
+#else
+#define TICK_US 1000
+#endif
+
+#if defined(ESP32)
+hw_timer_t* tickTimer = NULL;
+
+void IRAM_ATTR onTick() {
+  display.update();
+}
+
+void startTicks() {
+  tickTimer = timerBegin(1000000);  // 1MHz = 1us resolution
+  timerAttachInterrupt(tickTimer, &onTick);
+  timerAlarm(tickTimer, TICK_US, true, 0);
+}
+#elif defined(ARDUINO_ARCH_RP2040)
+repeating_timer_t tickTimer;
+
+bool onTick(repeating_timer_t* timer) {
+  display.update();
+  return true;
+}
+
+void startTicks() {
+  add_repeating_timer_us(-TICK_US, onTick, NULL, &tickTimer);
+}
+#else
+#error "MODE_ISR and MODE_BATCH need an ESP32 or RP2040 timer"
+#endif
+#endif
+
+const char* modeName() {
+  switch (MODE) {
+    case MODE_PUMP:    return "pump";
+    case MODE_SERVICE: return "service";
+    case MODE_ISR:     return "isr-10k";
+    case MODE_BATCH:   return "batch-1k";
+    case MODE_TIMER:   return "timer";
+    case MODE_PIO:     return "pio";
+    case MODE_RMT:     return "rmt";
+    default:           return "task";
+  }
+}
+
+// Start the mode; false if this board cannot run it
+bool startMode() {
+#if MODE == MODE_ISR || MODE == MODE_BATCH
+  display.setTickPeriod(TICK_US);
+#if MODE == MODE_BATCH
+  display.setStepsPerTick(28, 2);  // A byte per interrupt
+#endif
+  startTicks();
+  return true;
+#elif MODE == MODE_TIMER
+#if TM1637_HAS_TIMER
+  return display.beginTimer();
+#else
+  return false;
+#endif
+#elif MODE == MODE_PIO
+#if TM1637_HAS_PIO
+  return display.beginPIO();
+#else
+  return false;
+#endif
+#elif MODE == MODE_RMT
+#if TM1637_HAS_RMT
+  return display.beginRMT();
+#else
+  return false;
+#endif
+#elif MODE == MODE_TASK
+  return displayTask.begin(xPortGetCoreID());
+#else
+  return true;  // Polled: loop() drives the display
+#endif
+}
+
+// One unit of the application's own work
+volatile uint32_t sink;
+
+void work() {
+  for (uint8_t i = 0; i < 32; i++) sink = sink * 33 + i;
+}
+
+struct Result {
+  unsigned long work;       // Units of work()
+  unsigned long frames;     // Frames sent
+  unsigned long worstLate;  // Worst lateness of the periodic job, us
+};
+
+// Spin work() for one window, running the periodic job on time as far as
+// the display lets it, and keep the display busy if asked to
+Result measure(bool drive) {
+  Result result = { 0, 0, 0 };
+  uint8_t segments[4];
+  uint16_t value = 0;
+  unsigned long start = micros();
+  unsigned long next = start + PERIOD_US;
+  for (;;) {
+    unsigned long now = micros();
+    if (now - start >= WINDOW_US) break;
+    if ((long)(now - next) >= 0) {
+      if (now - next > result.worstLate) result.worstLate = now - next;
+      next += PERIOD_US;
+    }
+    work();
+    result.work++;
+    if (!drive) continue;
+
+#if MODE == MODE_SERVICE
+    display.service();
+#endif
+    if (display.isIdle()) {
+      value++;
+      for (uint8_t i = 0; i < 4; i++) segments[i] = display.encodeDigit((value + i) & 0x0F);
+      display.setSegments(segments);
+      result.frames++;
+#if MODE == MODE_PUMP
+      display.pump();
+#endif
+    }
+  }
+  return result;
+}
+
+void printColumn(const char* text, uint8_t width) {
+  Serial.print(text);
+  for (uint8_t n = strlen(text); n < width; n++) Serial.print(' ');
+}
+
+void printColumn(unsigned long value, uint8_t width) {
+  char text[12];
+  snprintf(text, sizeof(text), "%lu", value);
+  printColumn(text, width);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.println("TM1637Display32 Driver Mode Benchmark");
+
+  display.setBrightness(3);
+  display.clear();
+  while (!display.pump()) {}
+
+  // Reference: the same loop with the display left alone
+  Result base = measure(false);
+
+  if (!startMode()) {
+    Serial.print(modeName());
+    Serial.println(": not available on this board");
+    return;
+  }
+  Result run = measure(true);
+
+  // Post cost while the mode runs (waiting for idle is not counted)
+  uint8_t segments[4] = { 0, 0, 0, 0 };
+  unsigned long total = 0, worst = 0;
+  for (uint16_t i = 0; i < ROUNDS; i++) {
+    segments[i & 3] = display.encodeDigit(i & 0x0F);
+    unsigned long start = micros();
+    display.setSegments(segments);
+    unsigned long took = micros() - start;
+    total += took;
+    if (took > worst) worst = took;
+#if MODE == MODE_PUMP
+    display.pump();
+#elif MODE == MODE_SERVICE
+    while (!display.isIdle()) display.service();
+#else
+    while (!display.isIdle()) {}
+#endif
+  }
+
+  unsigned long lost = base.work > run.work ? base.work - run.work : 0;
+  unsigned long permille = (unsigned long)((unsigned long long)lost * 1000 / base.work);
+  char cpu[12];
+  snprintf(cpu, sizeof(cpu), "%lu.%lu", permille / 10, permille % 10);
+
+  printColumn("mode", 10);
+  printColumn("fps", 6);
+  printColumn("cpu%", 7);
+  printColumn("post ns", 9);
+  printColumn("post max us", 13);
+  Serial.println("jitter us");
+
+  printColumn(modeName(), 10);
+  printColumn(run.frames * 1000000UL / WINDOW_US, 6);
+  printColumn(cpu, 7);
+  printColumn(total * 1000UL / ROUNDS, 9);
+  printColumn(worst, 13);
+  Serial.println(run.worstLate > base.worstLate ? run.worstLate - base.worstLate : 0);
+}
+
+void loop() {
+}
@@ -0,0 +1,56 @@
+//  Arduino API shim for the host test build
+//
+//  Only what TM1637Display32 uses on a target without fast GPIO: the pins
+//  go to the bus model in BusModel.cpp, the clock is simulated and every
+//  reading of it moves it on by 1us, so busy-wait loops always end.
+
+#ifndef __TM1637_HOST_ARDUINO__
+#define __TM1637_HOST_ARDUINO__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT         0x0
+#define OUTPUT        0x1
+#define INPUT_PULLUP  0x2
+#define LOW           0x0
+#define HIGH          0x1
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+unsigned long micros();
+unsigned long millis();
+void delayMicroseconds(unsigned int us);
+
+// TM1637_CORE_ID() for the host build: the first thread to post gets 0, the
+// next ones 1, 2, 3, 1, 2, 3, ... so the main thread keeps a slot of its own
+uint8_t hostCoreId();
+
+class __FlashStringHelper;
+#define F(text) ((const __FlashStringHelper*)(text))
+
+// Writes to stdout; tests override write() to capture the text
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(const char* text, size_t length);
+  size_t print(const char* text);
+  size_t print(char c);
+  size_t print(int value);
+  size_t print(unsigned int value);
+  size_t print(long value);
+  size_t print(unsigned long value);
+  size_t println(const char* text);
+  size_t println(char c);
+  size_t println(int value);
+  size_t println(unsigned int value);
+  size_t println(long value);
+  size_t println(unsigned long value);
+  size_t println();
+};
+
+#endif // __TM1637_HOST_ARDUINO__
@@ -0,0 +1,285 @@
+//  Bus model for the host test build, and the Arduino.h shim on top of it
+
+#include "BusModel.h"
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <atomic>
+
+struct PinState {
+  uint8_t mode;
+  uint8_t latch;
+  bool held;          // bus::holdLow()
+};
+
+static PinState s_pins[BUS_PINS];
+static TM1637Model* s_chips = NULL;
+static std::atomic<unsigned long long> s_now(0);  // Read by every thread of the stress test
+static FILE* s_record = NULL;
+
+static void notifyChips() {
+  for (TM1637Model* chip = s_chips; chip != NULL; chip = chip->next()) chip->linesChanged();
+}
+
+TM1637Model::TM1637Model(uint8_t pinClk, uint8_t pinDIO) {
+  m_pinClk = pinClk;
+  m_pinDIO = pinDIO;
+  present = true;
+  nackBytes = 0;
+  keyCode = 0xFF;
+  minClockUs = 0;
+  memset(ram, 0, sizeof(ram));
+  control = 0;
+  transactions = 0;
+  m_pullDIO = false;
+  m_clk = bus::level(pinClk);
+  m_dio = bus::level(pinDIO);
+  m_inTx = false;
+  m_bit = 0;
+  m_shift = 0;
+  m_acking = false;
+  m_reading = false;
+  m_readBit = 0;
+  m_bytes = 0;
+  m_clkEdge = 0;
+  m_tooFast = false;
+  m_txStart = 0;
+  m_autoInc = true;
+  m_readMode = false;
+  m_addr = 0;
+  m_next = s_chips;
+  s_chips = this;
+}
+
+TM1637Model::~TM1637Model() {
+  for (TM1637Model** link = &s_chips; *link != NULL; link = &(*link)->m_next) {
+    if (*link == this) {
+      *link = m_next;
+      break;
+    }
+  }
+}
+
+std::string TM1637Model::takeLog() {
+  std::string log = m_log;
+  m_log.clear();
+  return log;
+}
+
+bool TM1637Model::pulls(uint8_t pin) const {
+  return pin == m_pinDIO && m_pullDIO;
+}
+
+void TM1637Model::setPull(bool low) {
+  m_pullDIO = low;
+  m_dio = bus::level(m_pinDIO);  // Our own doing, not an edge to decode
+}
+
+void TM1637Model::linesChanged() {
+  bool clk = bus::level(m_pinClk);
+  bool dio = bus::level(m_pinDIO);
+  bool clkWas = m_clk;
+  bool dioWas = m_dio;
+  m_clk = clk;
+  m_dio = dio;
+
+  if (clk && clkWas && dio != dioWas) {
+    if (!dio) {
+      // START: DIO falls while CLK is HIGH
+      if (!m_log.empty()) m_log += " | ";
+      m_txStart = m_log.size();
+      m_inTx = true;
+      m_bit = 0;
+      m_shift = 0;
+      m_acking = false;
+      m_reading = false;
+      m_bytes = 0;
+      m_tooFast = false;
+    } else if (m_inTx) {
+      // STOP: DIO rises while CLK is HIGH
+      m_inTx = false;
+      transactions++;
+      setPull(false);
+      if (s_record) fprintf(s_record, "%u/%u: %s\n", m_pinClk, m_pinDIO, m_log.c_str() + m_txStart);
+    }
+    return;
+  }
+  if (!m_inTx) return;
+
+  if (clk != clkWas) {
+    if (bus::now() - m_clkEdge < minClockUs) m_tooFast = true;
+    m_clkEdge = bus::now();
+  }
+  if (clk && !clkWas) {
+    // Rising CLK: the chip latches a data bit
+    if (!m_reading && m_bit < 8) {
+      if (dio) m_shift |= 1 << m_bit;
+      m_bit++;
+    }
+  } else if (!clk && clkWas) {
+    // Falling CLK: the chip changes what it drives on DIO
+    if (m_reading) {
+      if (++m_readBit < 8) {
+        setPull(!((keyCode >> m_readBit) & 1));
+      } else {
+        setPull(false);
+        m_reading = false;
+        m_bit = 9;  // Master's ACK clock, then STOP
+      }
+    } else if (m_acking) {
+      m_acking = false;
+      setPull(false);
+      m_bit = 0;
+      m_shift = 0;
+      if (m_readMode && m_bytes == 1) {
+        // Read-keys command acknowledged: shift the key data out, LSB first
+        m_reading = true;
+        m_readBit = 0;
+        char hex[4];
+        snprintf(hex, sizeof(hex), " %02X", keyCode);
+        m_log += hex;
+        setPull(!(keyCode & 1));
+      }
+    } else if (m_bit == 8) {
+      bool ack = present && nackBytes == 0 && !m_tooFast;
+      m_tooFast = false;
+      if (present && nackBytes > 0) nackBytes--;
+      byteDone(m_shift, ack);
+      m_acking = true;
+      setPull(ack);
+    }
+  }
+}
+
+void TM1637Model::byteDone(uint8_t b, bool acked) {
+  char hex[5];
+  snprintf(hex, sizeof(hex), m_bytes ? " %02X%s" : "%02X%s", b, acked ? "" : "?");
+  m_log += hex;
+  uint8_t index = m_bytes++;
+  if (!acked) return;
+
+  if (index == 0) {
+    m_readMode = false;
+    switch (b & 0xC0) {
+      case 0x40:  // Data command
+        m_autoInc = !(b & 0x04);
+        m_readMode = (b & 0x02) != 0;
+        break;
+      case 0xC0:  // Address command, data follows
+        m_addr = b & 0x07;
+        break;
+      case 0x80:  // Display control
+        control = b;
+        break;
+    }
+  } else if (m_addr < 6) {
+    ram[m_addr] = b;
+    if (m_autoInc) m_addr++;
+  }
+}
+
+TM1637Model* TM1637Model::next() const {
+  return m_next;
+}
+
+namespace bus {
+  void reset() {
+    for (uint8_t pin = 0; pin < BUS_PINS; pin++) {
+      s_pins[pin].mode = INPUT;
+      s_pins[pin].latch = HIGH;
+      s_pins[pin].held = false;
+    }
+    s_now = 0;
+  }
+
+  void holdLow(uint8_t pin, bool hold) {
+    s_pins[pin].held = hold;
+    notifyChips();
+  }
+
+  bool level(uint8_t pin) {
+    if (s_pins[pin].held) return false;
+    if (s_pins[pin].mode == OUTPUT && s_pins[pin].latch == LOW) return false;
+    for (TM1637Model* chip = s_chips; chip != NULL; chip = chip->next()) {
+      if (chip->pulls(pin)) return false;
+    }
+    return true;  // Pull-up
+  }
+
+  unsigned long long now() {
+    return s_now;
+  }
+
+  void advance(unsigned long us) {
+    s_now += us;
+  }
+
+  void record(FILE* out) {
+    s_record = out;
+  }
+
+  FILE* recording() {
+    return s_record;
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  s_pins[pin].mode = mode;
+  notifyChips();
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  s_pins[pin].latch = value;
+  notifyChips();
+}
+
+int digitalRead(uint8_t pin) {
+  return bus::level(pin) ? HIGH : LOW;
+}
+
+unsigned long micros() {
+  return (unsigned long)(s_now++);
+}
+
+unsigned long millis() {
+  return (unsigned long)(s_now++ / 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  s_now += us;
+}
+
+uint8_t hostCoreId() {
+  static std::atomic<unsigned> threads(0);
+  thread_local uint8_t id = 0xFF;
+  if (id == 0xFF) {
+    unsigned n = threads++;
+    id = n == 0 ? 0 : 1 + (n - 1) % 3;
+  }
+  return id;
+}
+
+size_t Print::write(const char* text, size_t length) { return fwrite(text, 1, length, stdout); }
+
+static size_t printTo(Print& out, const char* format, ...) {
+  char text[24];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  return out.write(text, length);
+}
+
+size_t Print::print(const char* text) { return write(text, strlen(text)); }
+size_t Print::print(char c) { return write(&c, 1); }
+size_t Print::print(int value) { return printTo(*this, "%d", value); }
+size_t Print::print(unsigned int value) { return printTo(*this, "%u", value); }
+size_t Print::print(long value) { return printTo(*this, "%ld", value); }
+size_t Print::print(unsigned long value) { return printTo(*this, "%lu", value); }
+size_t Print::println(const char* text) { return print(text) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(int value) { return print(value) + println(); }
+size_t Print::println(unsigned int value) { return print(value) + println(); }
+size_t Print::println(long value) { return print(value) + println(); }
+size_t Print::println(unsigned long value) { return print(value) + println(); }
+size_t Print::println() { return write("\n", 1); }
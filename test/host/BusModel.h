@@ -0,0 +1,95 @@
+//  Bus model for the host test build
+//
+//  Open-drain pins with pull-ups, and TM1637 chips that decode what the
+//  library clocks out (START, bytes with their ACK, STOP, key reads) the
+//  way the real chip does: data is latched on rising CLK, the chip pulls
+//  DIO LOW from the 8th falling edge to the 9th to acknowledge a byte.
+
+#ifndef __TM1637_BUSMODEL__
+#define __TM1637_BUSMODEL__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+#define BUS_PINS 64
+
+//! One TM1637 on a CLK/DIO pin pair. Registers itself with the bus while
+//! it exists; several may share a CLK pin.
+class TM1637Model {
+public:
+  TM1637Model(uint8_t pinClk, uint8_t pinDIO);
+  ~TM1637Model();
+
+  //! Acknowledge bytes (false: module missing or broken)
+  bool present;
+  //! Leave this many more bytes unacknowledged, then ACK again
+  uint8_t nackBytes;
+  //! Byte the chip answers the read-keys command with (0xFF = no key)
+  uint8_t keyCode;
+  //! Shortest CLK phase the chip follows; a byte clocked faster is not
+  //! acknowledged, as on a module with large line capacitors (0 = any rate)
+  unsigned minClockUs;
+
+  //! Display RAM (GRID1-6) and the last display control command (0 = none)
+  uint8_t ram[6];
+  uint8_t control;
+  //! Transactions seen (START to STOP)
+  unsigned transactions;
+
+  //! Transactions since the last call, one per START..STOP, separated by
+  //! " | ", bytes in hex, a '?' after each byte that was not acknowledged,
+  //! e.g. "40 | C0 06 5B 4F 66 | 8F". Key data read back follows the 42.
+  std::string takeLog();
+
+  // Called by the bus after any pin change
+  void linesChanged();
+  // True while the chip pulls this pin LOW
+  bool pulls(uint8_t pin) const;
+  TM1637Model* next() const;
+
+private:
+  uint8_t m_pinClk;
+  uint8_t m_pinDIO;
+  bool m_clk;            // Line levels seen last
+  bool m_dio;
+  bool m_pullDIO;
+
+  bool m_inTx;           // Between START and STOP
+  uint8_t m_bit;         // Data bit expected next, 8 = ACK clock, 9 = ignore until STOP
+  uint8_t m_shift;
+  bool m_acking;         // Between the 8th and 9th falling CLK edge
+  bool m_reading;        // Shifting key data out
+  uint8_t m_readBit;
+  uint8_t m_bytes;       // Bytes in this transaction
+  unsigned long long m_clkEdge;  // Time of the last CLK edge
+  bool m_tooFast;        // A CLK phase of this byte was under minClockUs
+  size_t m_txStart;      // Where this transaction starts in m_log
+  bool m_autoInc;
+  bool m_readMode;
+  uint8_t m_addr;
+  std::string m_log;
+
+  TM1637Model* m_next;
+
+  void byteDone(uint8_t b, bool acked);
+  void setPull(bool low);
+};
+
+namespace bus {
+  //! Release every pin, forget line overrides and restart the clock at 0
+  void reset();
+  //! Something else on the board holds the pin LOW (or lets go)
+  void holdLow(uint8_t pin, bool hold);
+  //! Current level of a pin (true = HIGH)
+  bool level(uint8_t pin);
+  //! Simulated time in microseconds
+  unsigned long long now();
+  void advance(unsigned long us);
+  //! Write every transaction to out as it ends, one "CLK/DIO: bytes" line
+  //! each like takeLog() (NULL: stop), and the file being written
+  void record(FILE* out);
+  FILE* recording();
+}
+
+#endif // __TM1637_BUSMODEL__
@@ -0,0 +1,65 @@
+//  Minimal test runner for the host test build
+
+#include "TestRunner.h"
+#include "BusModel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static TestCase* s_first = NULL;
+static TestCase** s_last = &s_first;
+static int s_failures = 0;
+
+TestCase::TestCase(const char* name, void (*run)())
+  : name(name), run(run), next(NULL) {
+  *s_last = this;  // Keep file order
+  s_last = &next;
+}
+
+void testFailed(const char* file, int line, const std::string& what) {
+  printf("  %s:%d: %s\n", file, line, what.c_str());
+  s_failures++;
+}
+
+void testCheckEqual(long long actual, long long expected, const char* text,
+                    const char* file, int line) {
+  if (actual == expected) return;
+  char what[256];
+  snprintf(what, sizeof(what), "%s is %lld, expected %lld", text, actual, expected);
+  testFailed(file, line, what);
+}
+
+void testCheckEqual(const std::string& actual, const std::string& expected,
+                    const char* text, const char* file, int line) {
+  if (actual == expected) return;
+  testFailed(file, line, std::string(text) + " is \"" + actual + "\", expected \"" + expected + "\"");
+}
+
+int main(int argc, char** argv) {
+  int tests = 0, failed = 0;
+  const char* logPath = getenv("TM1637_BUS_LOG");  // Every transaction, for comparing builds
+  FILE* log = logPath ? fopen(logPath, "w") : NULL;
+  if (logPath && !log) {
+    perror(logPath);
+    return 1;
+  }
+  bus::record(log);
+  for (TestCase* test = s_first; test != NULL; test = test->next) {
+    if (argc > 1 && strstr(test->name, argv[1]) == NULL) continue;  // Name filter
+    bus::reset();
+    if (log) fprintf(log, "== %s\n", test->name);
+    int before = s_failures;
+    test->run();
+    tests++;
+    if (s_failures != before) {
+      printf("FAIL %s\n", test->name);
+      failed++;
+    } else {
+      printf("ok   %s\n", test->name);
+    }
+  }
+  printf("%d tests, %d failed\n", tests, failed);
+  bus::record(NULL);
+  if (log) fclose(log);
+  return failed ? 1 : 0;
+}
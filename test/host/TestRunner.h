@@ -0,0 +1,35 @@
+//  Minimal test runner for the host test build
+//
+//  TEST(name) { ... } registers a test; CHECK()/CHECK_EQ() report a failure
+//  and carry on. Every test starts on a reset bus (see bus::reset()).
+
+#ifndef __TM1637_TESTRUNNER__
+#define __TM1637_TESTRUNNER__
+
+#include <string>
+
+struct TestCase {
+  const char* name;
+  void (*run)();
+  TestCase* next;
+  TestCase(const char* name, void (*run)());
+};
+
+void testFailed(const char* file, int line, const std::string& what);
+void testCheckEqual(long long actual, long long expected, const char* text,
+                    const char* file, int line);
+void testCheckEqual(const std::string& actual, const std::string& expected,
+                    const char* text, const char* file, int line);
+
+#define TEST(name) \
+  static void test_##name(); \
+  static TestCase testcase_##name(#name, test_##name); \
+  static void test_##name()
+
+#define CHECK(cond) \
+  do { if (!(cond)) testFailed(__FILE__, __LINE__, #cond); } while (0)
+
+#define CHECK_EQ(actual, expected) \
+  testCheckEqual((actual), (expected), #actual, __FILE__, __LINE__)
+
+#endif // __TM1637_TESTRUNNER__
@@ -0,0 +1,191 @@
+//  Bus cost per frame: update() steps and bytes on the wire, and the CPU
+//  time of the formatting calls
+//
+//  make bench builds and runs this. Each case prints what it measured and
+//  fails when a change makes that frame cost more than the limit below: the
+//  figures of the tree as it is, so a limit only ever moves down. Same
+//  counting as examples/DisplayBenchmark (bit delay 0, one step per update()).
+//  CPU times are host nanoseconds, the best of several runs; their limits
+//  are about five times what a desktop measures, so a loaded machine passes
+//  and work added per call (re-encoding, a loop over the message) does not.
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include <chrono>
+#include <ctype.h>
+#include <stdio.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#define CLK 2
+#define DIO 3
+
+struct Cost {
+  unsigned long steps;
+  unsigned bytes;
+};
+
+// Send whatever is posted, counting steps, and the bytes the chip saw
+static Cost send(TM1637Display32& display, TM1637Model& chip) {
+  Cost cost = { 0, 0 };
+  uint16_t bitDelay = display.getBitDelay();
+  display.setBitDelay(0);
+  while (!display.update() && cost.steps < 100000) cost.steps++;
+  display.setBitDelay(bitDelay);
+
+  std::string log = chip.takeLog();
+  for (size_t i = 0; i < log.size(); i++) {
+    if (isxdigit((unsigned char)log[i]) && (i + 1 == log.size() || !isxdigit((unsigned char)log[i + 1])))
+      cost.bytes++;  // Last hex digit of a byte
+  }
+  return cost;
+}
+
+// Print the cost and fail if it is over the limit
+static void report(const char* what, const Cost& cost, unsigned long maxSteps,
+                   unsigned maxBytes, const char* file, int line) {
+  printf("     %-24s %5lu steps %3u bytes\n", what, cost.steps, cost.bytes);
+  if (cost.steps > maxSteps || cost.bytes > maxBytes) {
+    char limit[128];
+    snprintf(limit, sizeof(limit), "%s over its limit of %lu steps, %u bytes",
+             what, maxSteps, maxBytes);
+    testFailed(file, line, limit);
+  }
+}
+
+#define CHECK_COST(what, cost, maxSteps, maxBytes) \
+  report(what, cost, maxSteps, maxBytes, __FILE__, __LINE__)
+
+TEST(bench_number_frames) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  CHECK_COST("full frame", send(display, chip), 216, 7);
+  display.showNumberDec(1235);
+  CHECK_COST("one digit", send(display, chip), 97, 3);
+  display.showNumberDec(5237);
+  CHECK_COST("first and last digit", send(display, chip), 160, 5);
+  display.showNumberDec(5237);
+  CHECK_COST("unchanged", send(display, chip), 0, 0);
+  display.setBrightness(3);
+  display.sendBrightness();
+  CHECK_COST("brightness only", send(display, chip), 34, 1);
+  display.invalidate();
+  CHECK_COST("invalidate()", send(display, chip), 216, 7);
+}
+
+TEST(bench_six_digits) {
+  TM1637Display32 display(CLK, DIO, 6);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(123456, false, 6);
+  CHECK_COST("6 digits full frame", send(display, chip), 272, 9);
+  display.showNumberDec(123457, false, 6);
+  CHECK_COST("6 digits one digit", send(display, chip), 97, 3);
+}
+
+TEST(bench_text) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.displayText("PLAY");
+  CHECK_COST("displayText full frame", send(display, chip), 216, 7);
+  display.displayText("PLAN");
+  CHECK_COST("displayText one letter", send(display, chip), 97, 3);
+}
+
+#if TM1637_SCROLL
+TEST(bench_scroll) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  CHECK(display.startScroll("SCROLL BENCH", 0));
+  Cost total = { 0, 0 };
+  unsigned frames = 0;
+  while (display.isScrolling() && frames < 100) {
+    Cost cost = send(display, chip);
+    total.steps += cost.steps;
+    total.bytes += cost.bytes;
+    frames++;
+  }
+  CHECK_COST("whole scroll", total, 2736, 89);
+  CHECK_EQ(frames, 18);  // 17 windows, then the step that ends it
+}
+#endif
+
+// showNumberBaseEx() is what showNumberHexEx() and the inherited API go through
+class BenchDisplay : public TM1637Display32 {
+public:
+  BenchDisplay(uint8_t pinClk, uint8_t pinDIO) : TM1637Display32(pinClk, pinDIO) {}
+  using TM1637Display32::showNumberBaseEx;
+};
+
+#define TIMED_RUNS 5
+
+// Nanoseconds per call of fn(display, i) for i = 0..calls-1, the best of
+// TIMED_RUNS runs. The frames are posted, not waited for.
+static double nsPerCall(void (*fn)(BenchDisplay&, unsigned), BenchDisplay& display,
+                        unsigned calls) {
+  double best = 1e12;
+  for (uint8_t run = 0; run < TIMED_RUNS; run++) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < calls; i++) fn(display, i);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (ns / calls < best) best = ns / calls;
+  }
+  return best;
+}
+
+// Print the time and fail if it is over the limit
+static void reportTime(const char* what, double ns, double maxNs, const char* file, int line) {
+  printf("     %-24s %8.0f ns\n", what, ns);
+  if (ns > maxNs) {
+    char limit[128];
+    snprintf(limit, sizeof(limit), "%s over its limit of %.0f ns", what, maxNs);
+    testFailed(file, line, limit);
+  }
+}
+
+#define CHECK_TIME(what, ns, maxNs) reportTime(what, ns, maxNs, __FILE__, __LINE__)
+
+TEST(bench_formatting_time) {
+  BenchDisplay display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  CHECK_TIME("showNumberBaseEx dec", nsPerCall([](BenchDisplay& d, unsigned i) {
+    d.showNumberBaseEx(10, (uint16_t)(i * 97), 0, false, 4, 0);
+  }, display, 20000), 1000);
+  CHECK_TIME("showNumberBaseEx hex", nsPerCall([](BenchDisplay& d, unsigned i) {
+    d.showNumberBaseEx(16, (uint16_t)(i * 97), 0, false, 4, 0);
+  }, display, 20000), 1000);
+  CHECK_TIME("showNumberDecEx int32", nsPerCall([](BenchDisplay& d, unsigned i) {
+    d.showNumberDecEx((int32_t)(i * 99991UL), 0, false, 4, 0);
+  }, display, 20000), 1000);
+  CHECK_TIME("displayText", nsPerCall([](BenchDisplay& d, unsigned i) {
+    d.displayText(i & 1 ? "HELO" : "PLAY");
+  }, display, 20000), 1000);
+}
+
+#if TM1637_SCROLL
+// updateScroll() calls that took a step, timed alone; the frames they post
+// are sent in between, untimed
+TEST(bench_scroll_step_time) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(0);
+  double best = 1e12;
+  for (uint8_t run = 0; run < TIMED_RUNS; run++) {
+    double ns = 0;
+    unsigned steps = 0;
+    for (uint8_t scroll = 0; scroll < 20; scroll++) {
+      CHECK(display.startScroll("SCROLL BENCH", 0));
+      while (display.isScrolling()) {
+        while (!display.isIdle()) display.update();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        display.updateScroll();
+        ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        steps++;
+      }
+    }
+    if (ns / steps < best) best = ns / steps;
+  }
+  chip.takeLog();
+  CHECK_TIME("updateScroll step", best, 1200);
+}
+#endif
@@ -0,0 +1,31 @@
+//  Object size per build profile, checked at compile time in every test
+//  build: make test builds the suite once per TM1637_PROFILE with its own
+//  TM1637_POST_SLOTS default, and once more without slots.
+//
+//  The limits are for this 64-bit host layout. MINIMAL stays within half of
+//  the 104 bytes one display took here before the profiles, TEXT within all
+//  of them, and FULL keeps about 10% headroom; the post slots and the
+//  startScroll() copy (TM1637_SCROLL_COPY) come on top.
+//  A member added to a profile shows up here on any machine.
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+
+#if TM1637_SCROLL
+#define HOST_SCROLL_RAM (TM1637_SCROLL_COPY + 1)
+#else
+#define HOST_SCROLL_RAM 0
+#endif
+
+#if TM1637_PROFILE == TM1637_PROFILE_MINIMAL
+#define HOST_RAM_BUDGET (52 + TM1637_POST_RAM)
+#elif TM1637_PROFILE == TM1637_PROFILE_TEXT
+#define HOST_RAM_BUDGET (104 + HOST_SCROLL_RAM + TM1637_POST_RAM)
+#else
+#define HOST_RAM_BUDGET (288 + HOST_SCROLL_RAM + TM1637_POST_RAM)
+#endif
+
+#if !TM1637_STATS && !TM1637_TRACE && !TM1637_WAVE_CACHE
+static_assert(sizeof(void*) != 8 || sizeof(TM1637Display32) <= HOST_RAM_BUDGET,
+              "TM1637Display32 outgrew its budget for this TM1637_PROFILE");
+#endif
@@ -0,0 +1,10 @@
+//  Linked against the library .cpp by make layout: in the same options it
+//  links, built in another TM1637_PROFILE it must not
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+
+int main() {
+  TM1637Display32 display(2, 3);
+  return display.getDigitCount() == 4 ? 0 : 1;
+}
@@ -0,0 +1,456 @@
+//  Scrolling, play() and the brightness effects as the chip sees them, and
+//  calls made while a step holds the claim
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+#include <string.h>
+#include <vector>
+
+#define CLK 2
+#define DIO 3
+
+#if TM1637_SCROLL
+// The transactions of one post, from the first START until the display is
+// idle again, and when the first of them ended
+struct Frame {
+  unsigned long long t;
+  std::string log;
+  std::string ram;  // Grids 1-4 after it, e.g. "00 00 76 79"
+  uint8_t control;
+};
+
+// Call update() every step_us for run_us, like a loop() with nothing else
+// to do, and collect the frames the chip takes in
+// (busy_us: a loop() that is also busy that long every 100th pass)
+static std::vector<Frame> watch(TM1637Display32& display, TM1637Model& chip,
+                                unsigned long run_us, unsigned long step_us = 50,
+                                unsigned long busy_us = 0) {
+  std::vector<Frame> frames;
+  unsigned long long end = bus::now() + run_us;
+  unsigned seen = chip.transactions;
+  unsigned long long first = 0;
+  for (unsigned pass = 1; bus::now() < end; pass++) {
+    display.update();
+    bus::advance(pass % 100 == 0 ? step_us + busy_us : step_us);
+    if (chip.transactions == seen) continue;
+    if (first == 0) first = bus::now();
+    if (!display.isIdle()) continue;
+    Frame frame;
+    char ram[16];
+    snprintf(ram, sizeof(ram), "%02X %02X %02X %02X", chip.ram[0], chip.ram[1], chip.ram[2],
+             chip.ram[3]);
+    frame.t = first;
+    frame.log = chip.takeLog();
+    frame.ram = ram;
+    frame.control = chip.control;
+    frames.push_back(frame);
+    seen = chip.transactions;
+    first = 0;
+  }
+  return frames;
+}
+
+// The 4-digit windows of text scrolled with pad blanks on either side, as
+// Frame::ram
+static std::vector<std::string> windows(TM1637Display32& display, const char* text, uint8_t pad) {
+  std::string padded = std::string(pad, ' ') + text + std::string(pad, ' ');
+  std::vector<std::string> result;
+  for (size_t i = 0; i + 4 <= padded.size(); i++) {
+    char ram[16];
+    snprintf(ram, sizeof(ram), "%02X %02X %02X %02X", display.charToSeg(padded[i]),
+             display.charToSeg(padded[i + 1]), display.charToSeg(padded[i + 2]),
+             display.charToSeg(padded[i + 3]));
+    result.push_back(ram);
+  }
+  return result;
+}
+
+// Within the update() step of watch(), plus the clock reads of update()
+static bool onSchedule(unsigned long long t, unsigned long long due) {
+  return t + 200 > due && t < due + 200;
+}
+
+static unsigned s_doneCalls;
+#if TM1637_HOOKS
+static void countDone(void* ctx) {
+  s_doneCalls++;
+  *(unsigned long long*)ctx = bus::now();
+}
+#endif
+
+// Count the ends of the display's animations in s_doneCalls, the last at
+// *doneAt (onAnimationDone() needs TM1637_HOOKS; without it the checks of
+// the count are left out)
+static void countDone(TM1637Display32& display, unsigned long long* doneAt) {
+  s_doneCalls = 0;
+#if TM1637_HOOKS
+  display.onAnimationDone(countDone, doneAt);
+#endif
+}
+
+// Scroll started by start(display) shows the windows of text 100ms apart
+// and ends one step after the last
+static void checkScroll(bool (*start)(TM1637Display32&), const char* text, uint8_t pad) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(10);
+  unsigned long long doneAt = 0;
+  countDone(display, &doneAt);
+  unsigned long long t0 = bus::now();
+  CHECK(start(display));
+  std::vector<Frame> frames = watch(display, chip, 3000000);
+  std::vector<std::string> expected = windows(display, text, pad);
+  CHECK_EQ(frames.size(), expected.size());
+  CHECK(!frames.empty() && frames[0].t - t0 < 3000);  // Shown at once
+  for (size_t i = 0; i < frames.size() && i < expected.size(); i++) {
+    CHECK_EQ(frames[i].ram, expected[i]);
+    CHECK(onSchedule(frames[i].t, frames[0].t + i * 100000));
+  }
+  CHECK(!display.isScrolling());
+#if TM1637_HOOKS
+  CHECK_EQ(s_doneCalls, 1);
+  // One step past the last window, with nothing sent for it
+  CHECK(onSchedule(doneAt, t0 + expected.size() * 100000));
+#endif
+}
+
+static const char s_hello[] = "HELLO";
+static char helloReader(uint32_t index, void* ctx) {
+  std::vector<uint32_t>* asked = (std::vector<uint32_t>*)ctx;
+  asked->push_back(index);
+  return index < 5 ? s_hello[index] : '\0';
+}
+static std::vector<uint32_t> s_asked;
+static constexpr auto HELLO = TM1637_TEXT("HELLO");
+
+TEST(scroll_shows_each_window_on_schedule) {
+  checkScroll([](TM1637Display32& d) { return d.startScroll("HELLO", 100); }, "HELLO", 4);
+  checkScroll([](TM1637Display32& d) { return d.startScroll("HELLO", 100, 0); }, "HELLO", 0);
+  checkScroll([](TM1637Display32& d) { return d.startScroll("HI", 100, 1); }, "HI", 1);
+}
+
+static char s_buffer[8];
+static const char s_long[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";  // 26, past TM1637_SCROLL_COPY
+
+TEST(scroll_copies_the_text) {
+  // The caller's buffer reused at once: the scroll still shows what it held
+  checkScroll([](TM1637Display32& d) {
+    strcpy(s_buffer, "HELLO");
+    bool started = d.startScroll(s_buffer, 100);
+    strcpy(s_buffer, "XXXXX");
+    return started;
+  }, "HELLO", 4);
+  checkScroll([](TM1637Display32& d) { return d.startScroll(s_long, 100, 0); },
+              std::string(s_long, TM1637_SCROLL_COPY).c_str(), 0);
+}
+
+TEST(scroll_borrowed_text_in_place) {
+  checkScroll([](TM1637Display32& d) { return d.startScrollBorrowed(s_hello, 100); }, "HELLO", 4);
+  checkScroll([](TM1637Display32& d) { return d.startScrollBorrowed(s_long, 100, 0); }, s_long, 0);
+}
+
+TEST(scroll_from_flash_reader_and_encoded_sources) {
+  checkScroll([](TM1637Display32& d) { return d.startScroll(F("HELLO"), 100); }, "HELLO", 4);
+  checkScroll([](TM1637Display32& d) { return d.startScrollEncoded(HELLO, 100, 2); }, "HELLO", 2);
+  s_asked.clear();
+  checkScroll([](TM1637Display32& d) { return d.startScroll(helloReader, &s_asked, 100); },
+              "HELLO", 4);
+  CHECK_EQ(s_asked.size(), 6);  // Each character once, in order, then the end
+  for (size_t i = 0; i < s_asked.size(); i++) CHECK_EQ(s_asked[i], i);
+}
+
+TEST(scroll_sends_only_the_digits_that_changed) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(10);
+  CHECK(display.startScroll("88", 100, 2));
+  std::vector<Frame> frames = watch(display, chip, 1000000);
+  CHECK_EQ(frames.size(), 3);
+  CHECK_EQ(frames[0].log, "40 | C0 00 00 7F 7F | 8F");  // "  88"
+  CHECK_EQ(frames[1].log, "40 | C1 7F 7F 00");        // " 88 ": grids 2-4
+  CHECK_EQ(frames[2].log, "40 | C0 7F 7F 00");        // "88  ": grids 1-3
+}
+
+#define SHOW_1 "06 06 06 06"
+#define SHOW_2 "5B 5B 5B 5B"
+#define SHOW_3 "4F 4F 4F 4F"
+
+// The ram of each frame, and each frame due start + the durations before it
+static void checkPlayed(const std::vector<Frame>& frames, const char* const shown[],
+                        const unsigned duration_ms[], size_t count) {
+  CHECK_EQ(frames.size(), count);
+  unsigned long long due = frames.empty() ? 0 : frames[0].t;
+  for (size_t i = 0; i < frames.size() && i < count; i++) {
+    CHECK_EQ(frames[i].ram, shown[i]);
+    CHECK(onSchedule(frames[i].t, due));
+    due += duration_ms[i] * 1000;
+  }
+}
+
+static const TM1637Frame s_counting[] = {
+  {{0x06, 0x06, 0x06, 0x06}, 50},
+  {{0x5B, 0x5B, 0x5B, 0x5B}, 20},
+  {{0x4F, 0x4F, 0x4F, 0x4F}, 30},
+};
+
+TEST(play_once_shows_each_frame_for_its_duration) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(10);
+  unsigned long long doneAt = 0;
+  countDone(display, &doneAt);
+#if TM1637_HOOKS
+  unsigned long long t0 = bus::now();
+#endif
+  CHECK(display.play(s_counting, 3));
+  CHECK(display.isAnimating());
+  std::vector<Frame> frames = watch(display, chip, 500000);
+  static const char* const shown[] = { SHOW_1, SHOW_2, SHOW_3 };
+  static const unsigned durations[] = { 50, 20, 30 };
+  checkPlayed(frames, shown, durations, 3);
+  CHECK_EQ(frames[0].log, "40 | C0 06 06 06 06 | 8F");
+  CHECK(!display.isAnimating());
+#if TM1637_HOOKS
+  CHECK_EQ(s_doneCalls, 1);
+  CHECK(onSchedule(doneAt, t0 + 100000));  // Once the last frame's 30ms are up
+#endif
+  CHECK_EQ(frames.back().ram, SHOW_3);     // And it stays up
+}
+
+TEST(play_loop_and_ping_pong_repeat_until_stopped) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(10);
+  unsigned long long doneAt = 0;
+  countDone(display, &doneAt);
+
+  CHECK(display.play(s_counting, 3, TM1637_PLAY_LOOP));
+  std::vector<Frame> frames = watch(display, chip, 290000);  // 2.9 rounds of 100ms
+  static const char* const looped[] = { SHOW_1, SHOW_2, SHOW_3, SHOW_1, SHOW_2, SHOW_3,
+                                        SHOW_1, SHOW_2, SHOW_3 };
+  static const unsigned loopedMs[] = { 50, 20, 30, 50, 20, 30, 50, 20, 30 };
+  checkPlayed(frames, looped, loopedMs, 9);
+  CHECK(display.isAnimating());
+
+  CHECK(display.play(s_counting, 3, TM1637_PLAY_PINGPONG));
+  frames = watch(display, chip, 260000);
+  static const char* const bounced[] = { SHOW_1, SHOW_2, SHOW_3, SHOW_2, SHOW_1, SHOW_2,
+                                         SHOW_3, SHOW_2, SHOW_1 };
+  static const unsigned bouncedMs[] = { 50, 20, 30, 20, 50, 20, 30, 20, 50 };
+  checkPlayed(frames, bounced, bouncedMs, 9);
+
+  display.stopAnimation();
+  CHECK(!display.isAnimating());
+  CHECK_EQ(watch(display, chip, 200000).size(), 0);
+  CHECK_EQ(s_doneCalls, 0);  // Stopped, not ended by itself
+}
+
+TEST(play_keeps_to_the_schedule_when_loop_is_busy) {
+  static const TM1637Frame blinking[] = {
+    {{0x06, 0x06, 0x06, 0x06}, 40},
+    {{0x5B, 0x5B, 0x5B, 0x5B}, 40},
+  };
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(10);
+  CHECK(display.play(blinking, 2, TM1637_PLAY_LOOP));
+  // 7ms lost every 5ms of loop(): each frame goes out late, but the next is
+  // still due on the original schedule
+  std::vector<Frame> frames = watch(display, chip, 990000, 50, 7000);
+  CHECK_EQ(frames.size(), 25);
+  for (size_t i = 0; i < frames.size(); i++) {
+    unsigned long long due = frames[0].t + i * 40000;
+    CHECK_EQ(frames[i].ram, i % 2 ? SHOW_2 : SHOW_1);
+    CHECK(frames[i].t + 200 > due && frames[i].t < due + 8000);
+  }
+}
+
+#if TM1637_EFFECTS
+// Display control commands alone, at_ms after t0. The command that is
+// already on the chip is not sent again.
+static void checkControl(const std::vector<Frame>& frames, unsigned long long t0,
+                         const char* const logs[], const unsigned at_ms[], size_t count) {
+  CHECK_EQ(frames.size(), count);
+  unsigned long long first = frames.empty() ? 0 : frames[0].t;
+  CHECK(first >= t0 + at_ms[0] * 1000 && first < t0 + at_ms[0] * 1000 + 3000);
+  for (size_t i = 0; i < frames.size() && i < count; i++) {
+    CHECK_EQ(frames[i].log, logs[i]);  // No 40/C0 block: the digits are not resent
+    CHECK_EQ(frames[i].ram, SHOW_1);
+    CHECK(onSchedule(frames[i].t, first + (at_ms[i] - at_ms[0]) * 1000));
+  }
+}
+
+// A display showing 1111, with nothing left in the chip's log
+static void showOnes(TM1637Display32& display, TM1637Model& chip) {
+  display.setBitDelay(10);
+  display.showNumberDec(1111);
+  CHECK(display.pump());
+  chip.takeLog();
+}
+
+TEST(fade_steps_one_level_at_a_time) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  showOnes(display, chip);
+
+  unsigned long long t0 = bus::now();
+  CHECK(display.fadeTo(2, 500));  // 5 levels down, 100ms apart
+  CHECK(display.isFading());
+  std::vector<Frame> frames = watch(display, chip, 700000);
+  static const char* const down[] = { "8E", "8D", "8C", "8B", "8A" };
+  static const unsigned downMs[] = { 100, 200, 300, 400, 500 };
+  checkControl(frames, t0, down, downMs, 5);
+  CHECK(!display.isFading());
+  CHECK_EQ(chip.control, 0x8A);
+
+  t0 = bus::now();
+  CHECK(display.fadeTo(0, 100, false));  // Then off at the end
+  frames = watch(display, chip, 300000);
+  static const char* const off[] = { "89", "80" };
+  static const unsigned offMs[] = { 50, 100 };
+  checkControl(frames, t0, off, offMs, 2);
+  CHECK_EQ(chip.control, 0x80);
+
+  t0 = bus::now();
+  CHECK(display.fadeTo(5, 0));  // At once, and back on
+  CHECK(!display.isFading());
+  frames = watch(display, chip, 100000);
+  static const char* const now[] = { "8D" };
+  static const unsigned nowMs[] = { 0 };
+  checkControl(frames, t0, now, nowMs, 1);
+}
+
+TEST(blink_counts_on_and_off_halves) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  showOnes(display, chip);
+
+  unsigned long long t0 = bus::now();
+  CHECK(display.blink(50, 30, 3));
+  CHECK(display.isBlinking());
+  std::vector<Frame> frames = watch(display, chip, 500000);
+  static const char* const blinks[] = { "87", "8F", "87", "8F", "87", "8F" };
+  static const unsigned blinksMs[] = { 50, 80, 130, 160, 210, 240 };
+  checkControl(frames, t0, blinks, blinksMs, 6);
+  CHECK(!display.isBlinking());  // Ends on after the third
+  CHECK_EQ(chip.control, 0x8F);
+
+  CHECK(display.blink(20, 20));  // Until stopped, here in an off half
+  frames = watch(display, chip, 110000);
+  CHECK_EQ(frames.size(), 5);
+  CHECK_EQ(chip.control, 0x87);
+  t0 = bus::now();
+  display.stopBlink();
+  CHECK(!display.isBlinking());
+  frames = watch(display, chip, 100000);
+  static const char* const stopped[] = { "8F" };
+  static const unsigned stoppedMs[] = { 0 };
+  checkControl(frames, t0, stopped, stoppedMs, 1);
+}
+#endif
+
+static TM1637Display32* s_display;
+static void (*s_inStep)();  // Run by the scroll reader on the first step
+static bool s_started;
+
+static const TM1637Frame s_frames[] = {
+  {{0x3F, 0x3F, 0x3F, 0x3F}, 10},
+};
+
+// Runs inside an animation step, so with the claim held: the same spot as
+// an ISR that interrupted the step. Nothing called from here may wait.
+static char stepReader(uint32_t index, void* ctx) {
+  if (index == 4 && s_inStep) s_inStep();
+  return "ABCDEFGH"[index & 7];
+}
+
+TEST(calls_during_an_animation_step_never_wait) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  s_display = &display;
+  s_inStep = [] {
+    s_started = s_display->play(s_frames, 1);
+    s_display->stopAnimation();
+  };
+  s_started = true;
+  CHECK(display.startScroll(stepReader, NULL, 10, 0));
+  display.pump();
+  chip.takeLog();
+
+  bus::advance(10000);
+  CHECK(display.pump());
+  CHECK(!s_started);               // The step had the engine
+  CHECK(!display.isAnimating());   // Stop asked for, applied by the next step
+  CHECK(!display.isScrolling());
+  CHECK(chip.takeLog() != "");     // The step's own frame still went out
+
+  bus::advance(10000);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "");    // Stopped there
+
+  s_inStep = NULL;
+  CHECK(display.play(s_frames, 1));
+  CHECK(display.pump());
+  CHECK_EQ(chip.ram[0], 0x3F);
+}
+
+TEST(posts_while_the_claim_is_held_never_wait) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  s_display = &display;
+  s_inStep = [] {
+    // A run of posts, with nobody able to take them
+    for (uint8_t i = 1; i <= 9; i++) {
+      uint8_t segments[] = { i, i };
+      s_display->setSegments(segments, 2, 2);
+    }
+    s_display->stopAnimation();
+  };
+  CHECK(display.startScroll(stepReader, NULL, 10, 0));
+  display.pump();
+
+  bus::advance(10000);
+  CHECK(display.pump());
+  CHECK(display.pump());
+  s_inStep = NULL;
+  // The step posted its window after the reader returned, so it comes last
+  CHECK_EQ(chip.ram[2], display.charToSeg('D'));
+  CHECK_EQ(chip.ram[3], display.charToSeg('E'));
+
+  // Slot taken: a new post goes straight through
+  uint8_t segments[] = { 0x3F, 0x3F };
+  display.setSegments(segments, 2, 2);
+  CHECK(display.pump());
+  CHECK_EQ(chip.ram[2], 0x3F);
+  CHECK_EQ(chip.ram[3], 0x3F);
+}
+
+#if TM1637_EFFECTS
+TEST(set_brightness_during_a_step_is_applied_next) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  s_display = &display;
+  CHECK(display.blink(10, 10));
+  CHECK(display.startScroll(stepReader, NULL, 10, 0));
+  display.pump();
+
+  s_inStep = [] {
+    s_display->setBrightness(2);
+    s_started = s_display->fadeTo(7, 100);
+  };
+  s_started = true;
+  bus::advance(10000);
+  CHECK(display.pump());
+  CHECK(!s_started);
+  CHECK(!display.isBlinking());    // Stopped by setBrightness()
+  CHECK(!display.isFading());
+
+  s_inStep = NULL;
+  display.sendBrightness();
+  CHECK(display.pump());
+  CHECK_EQ(chip.control, 0x8A);    // Brightness 2, display on
+}
+#endif
+#endif
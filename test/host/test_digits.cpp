@@ -0,0 +1,76 @@
+//  6-digit modules, and setDigitOrder() between positions and grids
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#if TM1637_MAX_DIGITS >= 6
+
+#define CLK 2
+#define DIO 3
+
+static const uint8_t s_six[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+static const uint8_t s_board[] = { 2, 1, 0, 5, 4, 3 };  // Common 6-digit wiring
+static const uint8_t s_new[] = { 0x10, 0x20, 0x30 };
+
+static void checkRam(TM1637Model& chip, const uint8_t expected[6]) {
+  for (uint8_t grid = 0; grid < 6; grid++) CHECK_EQ(chip.ram[grid], expected[grid]);
+}
+
+TEST(six_digits_in_one_burst) {
+  TM1637Display32 display(CLK, DIO, 6);
+  TM1637Model chip(CLK, DIO);
+  CHECK_EQ(display.getDigitCount(), 6);
+  display.setSegments(s_six, 6);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 01 02 03 04 05 06 | 8F");
+  checkRam(chip, s_six);
+
+  display.setSegments(s_new, 2, 4);  // Grids 4 and 5, past the first four
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C4 10 20");
+  static const uint8_t expected[] = { 0x01, 0x02, 0x03, 0x04, 0x10, 0x20 };
+  checkRam(chip, expected);
+}
+
+TEST(digit_order_maps_positions_to_grids) {
+  TM1637Display32 display(CLK, DIO, 6);
+  TM1637Model chip(CLK, DIO);
+  display.setDigitOrder(s_board);
+  display.setSegments(s_six, 6);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 03 02 01 06 05 04 | 8F");  // Still one burst, by grid
+
+  display.showNumberDec(123456, false, 6);
+  CHECK(display.pump());
+  static const uint8_t digits[] = { 0x4F, 0x5B, 0x06, 0x7D, 0x6D, 0x66 };
+  checkRam(chip, digits);
+}
+
+TEST(digit_order_with_part_of_the_display) {
+  TM1637Display32 display(CLK, DIO, 6);
+  TM1637Model chip(CLK, DIO);
+  display.setDigitOrder(s_board);
+  display.setSegments(s_six, 6);
+  CHECK(display.pump());
+  chip.takeLog();
+
+  display.setSegments(s_new, 2, 2);  // Positions 2 and 3 sit on grids 0 and 5
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "44 | C0 10 | C5 20");
+  static const uint8_t apart[] = { 0x10, 0x02, 0x01, 0x06, 0x05, 0x20 };
+  checkRam(chip, apart);
+
+  display.setSegments(s_new, 3, 4);  // Positions 4 and 5 (grids 4, 3); the third is off the end
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C3 20 10");
+  static const uint8_t clipped[] = { 0x10, 0x02, 0x01, 0x20, 0x10, 0x20 };
+  checkRam(chip, clipped);
+
+  display.setSegments(s_new, 1, 1);  // Position 1 is grid 1 on this board
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C1 10");
+}
+
+#endif
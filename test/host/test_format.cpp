@@ -0,0 +1,164 @@
+//  Digits showNumberDec()/showFixed() put on a 4- or 6-digit module
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include <stdint.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#define CLK 2
+#define DIO 3
+
+#define DASHES 0x40404040LL
+
+// The chip's first four grids, ram[0] in the top byte
+static long long shown(TM1637Display32& display, TM1637Model& chip) {
+  display.pump();
+  return (long long)chip.ram[0] << 24 | chip.ram[1] << 16 | chip.ram[2] << 8 | chip.ram[3];
+}
+
+// The 16-bit showNumberBaseEx() this library started from, for 4 digits at
+// position 0
+static long long original(TM1637Display32& display, int num, uint8_t dots,
+                          bool leading_zero) {
+  uint8_t base = 10;
+  bool negative = num < 0;
+  uint16_t value = negative ? -num : num;
+  uint8_t digits[4];
+  if (value == 0 && !leading_zero) {
+    for (uint8_t i = 0; i < 3; i++) digits[i] = 0;
+    digits[3] = display.encodeDigit(0);
+  } else {
+    for (int i = 3; i >= 0; --i) {
+      uint8_t digit = value % base;
+      if (digit == 0 && value == 0 && leading_zero == false)
+        digits[i] = 0;
+      else
+        digits[i] = display.encodeDigit(digit);
+      if (digit == 0 && value == 0 && negative) {
+        digits[i] = 0x40;
+        negative = false;
+      }
+      value /= base;
+    }
+    for (int i = 0; i < 4; ++i) {
+      digits[i] |= (dots & 0x80);
+      dots <<= 1;
+    }
+  }
+  return (long long)digits[0] << 24 | digits[1] << 16 | digits[2] << 8 | digits[3];
+}
+
+TEST(show_number_dec_matches_the_16_bit_original) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  static const uint8_t dots[] = { 0, 0x40, 0xF0 };
+  for (int num = -999; num <= 9999; num++) {
+    for (uint8_t d = 0; d < sizeof(dots); d++) {
+      for (uint8_t leading_zero = 0; leading_zero < 2; leading_zero++) {
+        if (num == 0 && !leading_zero && dots[d]) continue;  // See below
+        display.showNumberDecEx(num, dots[d], leading_zero);
+        long long expected = original(display, num, dots[d], leading_zero);
+        if (shown(display, chip) != expected) {
+          CHECK_EQ(shown(display, chip), expected);  // First difference only
+          return;
+        }
+      }
+    }
+  }
+}
+
+TEST(blank_padded_zero_keeps_its_dots) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDecEx(0, 0x40, false);  // The original dropped the dots
+  CHECK_EQ(shown(display, chip), 0x0080003FLL);
+}
+
+TEST(show_number_dec_too_wide_shows_low_digits) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(123456);
+  CHECK_EQ(shown(display, chip), 0x4F666D7DLL);  // 3456, as it always did
+  display.showNumberDec(-12345);
+  CHECK_EQ(shown(display, chip), 0x5B4F666DLL);  // 2345: the sign does not fit
+  display.showNumberDec(-1000);
+  CHECK_EQ(shown(display, chip), 0x063F3F3FLL);
+  display.showNumberDecEx(98765, 0x40, true);
+  CHECK_EQ(shown(display, chip), 0x7F877D6DLL);  // 87.65
+}
+
+TEST(show_number_dec_checked_dashes_what_does_not_fit) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDecChecked(123456);
+  CHECK_EQ(shown(display, chip), DASHES);
+  display.showNumberDecChecked(-12345);
+  CHECK_EQ(shown(display, chip), DASHES);
+  display.showNumberDecChecked(-1000);
+  CHECK_EQ(shown(display, chip), DASHES);
+  display.showNumberDecChecked(INT32_MAX);
+  CHECK_EQ(shown(display, chip), DASHES);
+  display.showNumberDecChecked(INT32_MIN);
+  CHECK_EQ(shown(display, chip), DASHES);
+  display.showNumberDecChecked(-999);
+  CHECK_EQ(shown(display, chip), 0x406F6F6FLL);  // What fits is shown as usual
+  display.showNumberDecChecked(5, 0x40, true);
+  CHECK_EQ(shown(display, chip), 0x3FBF3F6DLL);
+
+  display.clear();
+  display.showNumberDecChecked(12, 0, false, 2, 2);
+  CHECK_EQ(shown(display, chip), 0x0000065BLL);
+  display.showNumberDecChecked(123, 0, false, 2, 2);  // Only the field is dashed
+  CHECK_EQ(shown(display, chip), 0x00004040LL);
+}
+
+TEST(show_number_dec_edges_that_fit) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(-999);
+  CHECK_EQ(shown(display, chip), 0x406F6F6FLL);
+  display.showNumberDec(9999);
+  CHECK_EQ(shown(display, chip), 0x6F6F6F6FLL);
+}
+
+#if TM1637_MAX_DIGITS >= 6
+TEST(six_digits_show_six_digit_numbers) {
+  TM1637Display32 display(CLK, DIO, 6);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(123456, false, 6);
+  display.pump();
+  static const uint8_t expected[] = { 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D };
+  for (uint8_t i = 0; i < 6; i++) CHECK_EQ(chip.ram[i], expected[i]);
+  display.showNumberDec(-99999, false, 6);
+  display.pump();
+  CHECK_EQ(chip.ram[0], 0x40);
+  CHECK_EQ(chip.ram[5], 0x6F);
+  display.showNumberDec(1234567, false, 6);
+  display.pump();
+  static const uint8_t low[] = { 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07 };  // 234567
+  for (uint8_t i = 0; i < 6; i++) CHECK_EQ(chip.ram[i], low[i]);
+  display.showNumberDecChecked(1234567, 0, false, 6);
+  display.pump();
+  for (uint8_t i = 0; i < 6; i++) CHECK_EQ(chip.ram[i], 0x40);
+}
+#endif
+
+TEST(show_fixed_rounds_and_carries) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showFixed(1234, 2);  // 12.34
+  CHECK_EQ(shown(display, chip), 0x06DB4F66LL);
+  display.showFixed(99996, 3);  // 99.996 -> 100.0
+  CHECK_EQ(shown(display, chip), 0x063FBF3FLL);
+  display.showFixed(-9995, 3);  // -9.995 -> -10.0
+  CHECK_EQ(shown(display, chip), 0x4006BF3FLL);
+  display.showFixed(5, 2);  // 0.05
+  CHECK_EQ(shown(display, chip), 0x00BF3F6DLL);
+  display.showFixed(-4, 3);  // -0.004 rounds to 0.00, no "-0"
+  CHECK_EQ(shown(display, chip), 0x00BF3F3FLL);
+  display.showFixed(INT32_MIN, 9);  // -2.147483648
+  CHECK_EQ(shown(display, chip), 0x40DB066DLL);
+  display.showFixed(INT32_MAX, 0);
+  CHECK_EQ(shown(display, chip), DASHES);
+}
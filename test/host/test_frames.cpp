@@ -0,0 +1,266 @@
+//  Byte streams TM1637Display32 puts on the bus
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#define CLK 2
+#define DIO 3
+
+TEST(full_frame_first) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+  CHECK_EQ(chip.ram[0], 0x06);
+  CHECK_EQ(chip.ram[3], 0x66);
+  CHECK_EQ(chip.control, 0x8F);
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+}
+
+TEST(changed_digit_only) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  display.pump();
+  chip.takeLog();
+  display.showNumberDec(1235);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C3 6D");
+  CHECK_EQ(chip.ram[3], 0x6D);
+}
+
+TEST(unchanged_frame_sends_nothing) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  display.pump();
+  unsigned transactions = chip.transactions;
+  display.showNumberDec(1234);
+  CHECK(display.update());  // Idle at once
+  CHECK_EQ(chip.transactions, transactions);
+}
+
+TEST(fixed_address_for_scattered_digits) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  display.pump();
+  chip.takeLog();
+  display.showNumberDec(5237);  // Digits 0 and 3: two short blocks beat four bytes
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "44 | C0 6D | C3 07");
+  CHECK_EQ(chip.ram[0], 0x6D);
+  CHECK_EQ(chip.ram[1], 0x5B);
+  CHECK_EQ(chip.ram[3], 0x07);
+}
+
+TEST(brightness_only_frame) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  display.pump();
+  chip.takeLog();
+  display.setBrightness(3);
+  display.sendBrightness();
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "8B");
+  display.setBrightness(3, false);
+  display.sendBrightness();
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "83");
+}
+
+TEST(invalidate_resends_everything) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  display.pump();
+  chip.takeLog();
+  display.invalidate();
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+}
+
+#if TM1637_RETRIES
+TEST(nack_is_retried) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  chip.nackBytes = 1;
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40? | 40 | C0 06 5B 4F 66 | 8F");
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+}
+
+TEST(missing_chip_gives_up_with_noack) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  chip.present = false;
+  display.setRetries(2);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40? | 40? | 40?");
+  CHECK_EQ(display.getError(), TM1637_ERR_NOACK);
+
+  // Back on the bus: the next post goes out in full and clears the error
+  chip.present = true;
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+}
+
+TEST(ack_check_off_ignores_nack) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  chip.present = false;
+  display.setAckCheck(false);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40? | C0? 06? 5B? 4F? 66? | 8F?");
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+}
+
+#endif
+
+TEST(frames_sent_counts_finished_frames_only) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  display.pump();
+  CHECK_EQ(display.framesSent(), 1);
+
+#if TM1637_RETRIES
+  chip.nackBytes = 1;  // Retried: still one frame
+  display.showNumberDec(1235);
+  display.pump();
+  CHECK_EQ(display.framesSent(), 2);
+
+  chip.present = false;  // Given up: none
+  display.showNumberDec(1236);
+  display.pump();
+  CHECK_EQ(display.framesSent(), 2);
+  CHECK_EQ(display.getError(), TM1637_ERR_NOACK);
+#endif
+}
+
+#if TM1637_RETRIES
+TEST(calibrate_keeps_a_margin) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(8);
+  CHECK_EQ(display.calibrateBitDelay(1), 2);  // The model ACKs at any rate: 1us + 50%
+  CHECK_EQ(display.calibrateBitDelay(0), 0);  // 0 works too: no margin to add
+  CHECK_EQ(display.getBitDelay(), 0);
+  CHECK_EQ(chip.ram[0], 0);  // Test frames showed the cleared display
+
+  chip.present = false;
+  display.setBitDelay(8);
+  CHECK_EQ(display.calibrateBitDelay(1), 8);  // Never ACKed: left alone
+}
+
+TEST(calibrate_slows_down_for_a_slow_module) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  chip.minClockUs = 20;
+  display.setBitDelay(0);
+  uint16_t us = display.calibrateBitDelay(0);
+  CHECK(us >= 20);
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);  // The repaint at the new delay got through
+
+  chip.takeLog();
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66");  // Every byte ACKed, brightness already sent
+}
+#endif
+
+#if TM1637_WATCHDOG
+TEST(timeouts_use_the_retry_budget) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setAckCheck(false);
+  display.setBitDelay(100);  // A frame takes ~23ms
+  display.setTimeout(1);
+  display.setRetries(2);
+  display.showNumberDec(1234);
+  CHECK(display.pump(100000));
+  CHECK_EQ(chip.transactions, 3u);  // Cut off three times by the recovery STOP
+  CHECK_EQ(display.getError(), TM1637_ERR_TIMEOUT);
+
+  // Given up: nothing more goes out until the next post
+  CHECK(display.pump(100000));
+  CHECK_EQ(chip.transactions, 3u);
+
+  display.setTimeout(500);
+  display.showNumberDec(1234);
+  CHECK(display.pump(100000));
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+  CHECK_EQ(chip.ram[3], 0x66);
+}
+#endif
+
+#if TM1637_KEYS
+TEST(key_scan_reads_keys) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  chip.keyCode = 0xF7;  // K1 + SG1
+  display.setKeyScan(10, 1);
+  display.pump();
+  CHECK_EQ(chip.takeLog(), "42 F7");
+  CHECK_EQ(display.getKeys(), 0);
+
+  uint8_t key = 0xFF;
+  bool pressed = false;
+  CHECK(display.readKeyEvent(key, pressed));
+  CHECK_EQ(key, 0);
+  CHECK(pressed);
+
+  // Released at the next scan, 10ms on
+  chip.keyCode = 0xFF;
+  bus::advance(10000);
+  display.update();
+  display.pump();
+  CHECK_EQ(chip.takeLog(), "42 FF");
+  CHECK(display.readKeyEvent(key, pressed));
+  CHECK(!pressed);
+  CHECK_EQ(display.getKeys(), TM1637_NO_KEY);
+}
+
+TEST(key_scan_keeps_frame_error) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setRetries(2);
+  chip.nackBytes = 3;  // The frame and both retries fail, the chip answers again after
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40? | 40? | 40?");
+  CHECK_EQ(display.getError(), TM1637_ERR_NOACK);
+
+  display.setKeyScan(10, 1);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "42 FF");
+  CHECK_EQ(display.getError(), TM1637_ERR_NOACK);  // Only a display frame clears it
+  CHECK_EQ(display.framesSent(), 0);               // Nor does a scan count as one
+}
+
+TEST(key_scan_leaves_display_alone) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  chip.keyCode = 0xEF;  // K2 + SG1
+  display.setKeyScan(10, 1);
+  display.showNumberDec(1234);  // Starts at once, the scan follows it
+  CHECK(display.pump());
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F | 42 EF");
+  CHECK_EQ(display.getKeys(), 8);
+  CHECK_EQ(chip.ram[0], 0x06);
+
+  display.showNumberDec(1235);  // Chip mirror untouched by the read
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C3 6D");
+}
+#endif
@@ -0,0 +1,53 @@
+//  TM1637MultiDisplay: modules clocked in lockstep
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#define CLK 2
+
+static const uint8_t s_pinsDIO[] = { 3, 4 };
+static const uint8_t s_one[] = { 0x06, 0x06, 0x06, 0x06 };
+static const uint8_t s_two[] = { 0x5B, 0x5B, 0x5B, 0x5B };
+
+TEST(multi_sends_each_module_its_digits) {
+  TM1637MultiDisplay displays(CLK, s_pinsDIO, 2);
+  TM1637Model first(CLK, 3);
+  TM1637Model second(CLK, 4);
+  displays.setSegments(0, s_one);
+  displays.setSegments(1, s_two);
+  CHECK(displays.pump());
+  CHECK_EQ(first.takeLog(), "40 | C0 06 06 06 06 | 8F");
+  CHECK_EQ(second.takeLog(), "40 | C0 5B 5B 5B 5B | 8F");
+  CHECK_EQ(displays.getMissing(), 0);
+}
+
+TEST(multi_reports_missing_modules) {
+  TM1637MultiDisplay displays(CLK, s_pinsDIO, 2);
+  TM1637Model first(CLK, 3);
+  TM1637Model second(CLK, 4);
+  second.present = false;
+  displays.setSegments(0, s_one);
+  CHECK(displays.pump());
+  CHECK_EQ(second.takeLog(), "40? | C0? 00? 00? 00? 00? | 8F?");
+  CHECK_EQ(displays.getMissing(), 2);
+
+  second.present = true;
+  displays.setSegments(1, s_two);
+  CHECK(displays.pump());
+  CHECK_EQ(displays.getMissing(), 0);
+  CHECK_EQ(second.ram[0], 0x5B);
+}
+
+TEST(multi_bit_delay_is_set_at_run_time) {
+  TM1637MultiDisplay displays(CLK, s_pinsDIO, 2);
+  TM1637Model first(CLK, 3);
+  TM1637Model second(CLK, 4);
+  displays.setBitDelay(50);
+  CHECK_EQ(displays.getBitDelay(), 50);
+  displays.setSegments(0, s_one);
+  CHECK(!displays.pump(5000));    // Over 200 steps at 50us each
+  CHECK(displays.pump(20000));
+  CHECK_EQ(first.ram[0], 0x06);
+}
@@ -0,0 +1,107 @@
+//  TM1637_STATS counters (make -C test/host instrumented)
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#if TM1637_STATS
+
+#define CLK 2
+#define DIO 3
+
+static TM1637Stats stats(const TM1637Display32& display) {
+  TM1637Stats s;
+  display.getStats(s);
+  return s;
+}
+
+TEST(stats_count_frames_bytes_and_steps) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  TM1637Stats s = stats(display);
+  CHECK_EQ(s.framesStarted, 1);
+  CHECK_EQ(s.framesCompleted, 1);
+  CHECK_EQ(s.framesAborted, 0);
+  CHECK_EQ(s.framesSuperseded, 0);
+  CHECK_EQ(s.bytesSent, 7);          // 40 | C0 + 4 digits | 8F
+  CHECK_EQ(s.updateSteps, 217);
+  CHECK(s.updateCalls >= s.updateSteps);
+
+  display.showNumberDec(1235);       // 40 | C3 6D
+  CHECK(display.pump());
+  display.showNumberDec(1235);       // Unchanged: no frame
+  CHECK(display.pump());
+  s = stats(display);
+  CHECK_EQ(s.framesStarted, 2);
+  CHECK_EQ(s.framesCompleted, 2);
+  CHECK_EQ(s.bytesSent, 10);
+  CHECK(s.latencyUsMin > 0);
+  CHECK(s.latencyUsMin <= s.latencyUsAvg && s.latencyUsAvg <= s.latencyUsMax);
+}
+
+TEST(stats_count_superseded_posts) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1111);
+  display.update();                  // In flight
+  display.showNumberDec(2222);       // Replaced twice before the bus is free
+  display.showNumberDec(3333);
+  display.showNumberDec(4444);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 06 06 06 | 8F | 40 | C0 66 66 66 66");
+  TM1637Stats s = stats(display);
+  CHECK_EQ(s.framesCompleted, 2);
+  CHECK_EQ(s.framesSuperseded, 2);
+}
+
+TEST(stats_count_aborted_frames_and_reset) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  chip.nackBytes = 1;
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  TM1637Stats s = stats(display);
+  CHECK_EQ(s.framesStarted, 2);      // The retry counts as a frame
+  CHECK_EQ(s.framesAborted, 1);
+  CHECK_EQ(s.framesCompleted, 1);
+  CHECK_EQ(s.bytesSent, 14);         // Both frames as launched
+
+  display.resetStats();
+  display.update();                  // Applies it
+  s = stats(display);
+  CHECK_EQ(s.framesStarted, 0);
+  CHECK_EQ(s.framesAborted, 0);
+  CHECK_EQ(s.bytesSent, 0);
+  CHECK(s.updateSteps <= 1);
+}
+
+TEST(stats_count_rate_limited_calls) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(50);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  TM1637Stats s = stats(display);
+  CHECK_EQ(s.updateSteps, 217);
+  CHECK(s.updateRateLimited > 0);    // pump() calls in between the steps
+  CHECK_EQ(s.updateCalls, s.updateSteps + s.updateRateLimited);
+}
+
+#if TM1637_WAVE_CACHE
+TEST(stats_count_wave_cache_hits) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  display.invalidate();
+  CHECK(display.pump());
+  TM1637Stats s = stats(display);
+  CHECK_EQ(s.waveCacheMisses, 1);    // Rendered once, replayed once
+  CHECK_EQ(s.waveCacheHits, 1);
+}
+#endif
+
+#endif
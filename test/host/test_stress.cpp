@@ -0,0 +1,50 @@
+//  Posting from several threads while another one runs update()
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+#include <atomic>
+#include <thread>
+
+#define CLK 2
+#define DIO 3
+
+#define STRESS_POSTS 3000
+
+// Threads stand in for cores, so the posts need a slot each (the default
+// test build has 4)
+#if TM1637_POST_SLOTS >= 4
+
+// Every producer counts up on its own digit; the update() thread is the only
+// one that touches the pins. Whatever the interleaving, every producer's last
+// post must reach the chip and the posts must never wait on each other.
+TEST(stress_three_producers_one_update_thread) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  std::atomic<bool> stop(false);
+  FILE* log = bus::recording();
+  bus::record(NULL);  // The interleaving, so the bytes, differ from run to run
+
+  std::thread updater([&] {
+    while (!stop.load()) display.update();
+  });
+  std::thread producers[3];
+  for (uint8_t digit = 0; digit < 3; digit++) {
+    producers[digit] = std::thread([&display, digit] {
+      for (int i = 1; i <= STRESS_POSTS; i++) {
+        uint8_t segments = (uint8_t)(i & 0x7F);
+        display.setSegments(&segments, 1, digit);
+      }
+    });
+  }
+  for (uint8_t digit = 0; digit < 3; digit++) producers[digit].join();
+  stop.store(true);
+  updater.join();
+
+  CHECK(display.pump(100000));
+  bus::record(log);
+  for (uint8_t digit = 0; digit < 3; digit++) CHECK_EQ(chip.ram[digit], STRESS_POSTS & 0x7F);
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+}
+#endif
@@ -0,0 +1,96 @@
+//  TM1637Display32T steps frames itself: it must put exactly the bytes and
+//  the steps of TM1637Display32 on the bus
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#include <stdio.h>
+
+#define CLK 2
+#define DIO 3
+
+// The bytes of every transaction, then the update() calls it took to idle
+template <class D>
+static std::string settle(D& display, TM1637Model& chip) {
+  unsigned calls = 1;
+  while (!display.update() && calls < 100000) calls++;
+  char tail[16];
+  snprintf(tail, sizeof(tail), " / %u", calls);
+  return chip.takeLog() + tail;
+}
+
+template <class D>
+static std::string frames(D& display) {
+  TM1637Model chip(CLK, DIO);
+  std::string log;
+  display.showNumberDec(1234);
+  log += settle(display, chip) + "\n";
+  display.showNumberDec(1235);   // One digit
+  log += settle(display, chip) + "\n";
+  display.showNumberDec(5237);   // Fixed address
+  log += settle(display, chip) + "\n";
+  display.setBrightness(3);
+  display.sendBrightness();
+  log += settle(display, chip) + "\n";
+  display.setBitDelay(8);
+  display.clear();
+  log += settle(display, chip) + "\n";
+  CHECK_EQ(chip.ram[0], 0);
+  CHECK_EQ(chip.control, 0x8B);
+  return log;
+}
+
+TEST(template_sends_the_same_frames) {
+  TM1637Display32 display(CLK, DIO);
+  std::string expected = frames(display);
+  bus::reset();
+  TM1637Display32T<CLK, DIO> fixed;
+  CHECK_EQ(frames(fixed), expected);
+  CHECK_EQ(fixed.getError(), TM1637_ERR_NONE);
+}
+
+TEST(template_pump_finishes_the_frame) {
+  TM1637Display32T<CLK, DIO> display;
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(42);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 00 00 66 5B | 8F");
+  CHECK(display.isIdle());
+}
+
+#if TM1637_RETRIES
+template <class D>
+static std::string retried(D& display) {
+  TM1637Model chip(CLK, DIO);
+  chip.nackBytes = 1;  // Bus reset, then the frame again
+  display.showNumberDec(1234);
+  std::string log = settle(display, chip);
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+  return log;
+}
+
+TEST(template_retries_the_same_way) {
+  TM1637Display32 display(CLK, DIO);
+  std::string expected = retried(display);
+  bus::reset();
+  TM1637Display32T<CLK, DIO> fixed;
+  CHECK_EQ(retried(fixed), expected);
+}
+#endif
+
+#if TM1637_MAX_DIGITS >= 6
+TEST(template_six_digits) {
+  TM1637Display32 display(CLK, DIO, 6);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(123456, false, 6);
+  std::string expected = settle(display, chip);
+  bus::reset();
+  TM1637Display32T<CLK, DIO, 6> fixed;
+  TM1637Model fixedChip(CLK, DIO);
+  fixed.showNumberDec(123456, false, 6);
+  CHECK_EQ(settle(fixed, fixedChip), expected);
+  for (uint8_t k = 0; k < 6; k++) CHECK_EQ(fixedChip.ram[k], chip.ram[k]);
+}
+#endif
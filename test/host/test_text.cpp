@@ -0,0 +1,82 @@
+//  TM1637_TEXT()/showEncoded() against displayText()
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#define CLK 2
+#define DIO 3
+
+// Encoded by the compiler: these fail the build, not the run
+static constexpr auto PLAY = TM1637_TEXT("PLAY");
+static_assert(PLAY.length == 4, "one byte per character");
+static_assert(PLAY.seg[0] == 0x73 && PLAY.seg[1] == 0x38 && PLAY.seg[2] == 0x77 &&
+              PLAY.seg[3] == 0x6E, "P L A Y");
+static_assert(TM1637_TEXT("").length == 0, "empty label");
+static_assert(TM1637_TEXT("8").seg[0] == tm1637_detail::encodeDigit(8), "digits share the font");
+
+// Printable ASCII 0x20-0x7f, as the compiler encodes it
+static constexpr auto PRINTABLE = TM1637_TEXT(
+  " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\x7f");
+static_assert(PRINTABLE.length == 96, "0x20-0x7f");
+
+// The frames and chip RAM displayText() gives, then the ones showEncoded() gives
+// on a fresh display and chip
+template<unsigned N>
+static void checkSame(const char* text, const TM1637Segments<N>& label, uint8_t pos,
+                      uint8_t digits = 4) {
+  std::string textLog, labelLog;
+  uint8_t textRam[6];
+  {
+    TM1637Display32 display(CLK, DIO, digits);
+    TM1637Model chip(CLK, DIO);
+    display.displayText(text, pos);
+    CHECK(display.pump());
+    textLog = chip.takeLog();
+    memcpy(textRam, chip.ram, sizeof(textRam));
+  }
+  TM1637Display32 display(CLK, DIO, digits);
+  TM1637Model chip(CLK, DIO);
+  display.showEncoded(label, pos);
+  CHECK(display.pump());
+  labelLog = chip.takeLog();
+  CHECK_EQ(labelLog, textLog);
+  for (uint8_t i = 0; i < digits; i++) CHECK_EQ(chip.ram[i], textRam[i]);
+}
+
+TEST(char_to_seg_uses_the_constexpr_font) {
+  TM1637Display32 display(CLK, DIO);
+  for (int c = 0; c < 256; c++) {
+    uint8_t expected = (c >= 0x20 && c < 0x80) ? PRINTABLE.seg[c - 0x20] : 0x00;
+    CHECK_EQ(display.charToSeg((char)c), expected);
+  }
+}
+
+TEST(show_encoded_matches_display_text) {
+  checkSame("PLAY", PLAY, 0);
+  checkSame("Ab-9", TM1637_TEXT("Ab-9"), 0);
+  checkSame("?_ =", TM1637_TEXT("?_ ="), 0);  // Blanks and fallbacks alike
+}
+
+TEST(show_encoded_matches_display_text_at_a_position) {
+  checkSame("Hi", TM1637_TEXT("Hi"), 2);      // Digits before it blanked
+  checkSame("Hi", TM1637_TEXT("Hi"), 1);      // And after it
+  checkSame("HELLO", TM1637_TEXT("HELLO"), 0);  // Cut to the display
+  checkSame("HELLO", TM1637_TEXT("HELLO"), 3);
+#if TM1637_MAX_DIGITS >= 6
+  checkSame("HELLO", TM1637_TEXT("HELLO"), 1, 6);
+#endif
+  checkSame("", TM1637_TEXT(""), 0);
+}
+
+TEST(show_encoded_past_the_end_blanks_the_display) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showEncoded(PLAY);
+  CHECK(display.pump());
+  chip.takeLog();
+  display.showEncoded(PLAY, 4);
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 00 00 00 00");
+}
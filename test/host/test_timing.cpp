@@ -0,0 +1,254 @@
+//  When update() steps: batches per call, tick-counted pacing, deadlines
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+
+#define CLK 2
+#define DIO 3
+
+#define FRAME_STEPS 217  // 40 | C0 + 4 digits | 8F
+
+#if TM1637_PACING
+// update() calls until idle, the last one included
+static unsigned callsToIdle(TM1637Display32& display) {
+  unsigned calls = 1;
+  while (!display.update() && calls < 100000) calls++;
+  return calls;
+}
+
+TEST(batched_steps_send_the_same_bytes) {
+  static const uint8_t batches[] = { 1, 7, 28, 100, 216, 255 };
+  for (uint8_t i = 0; i < sizeof(batches); i++) {
+    bus::reset();
+    TM1637Display32 display(CLK, DIO);
+    TM1637Model chip(CLK, DIO);
+    display.setBitDelay(0);
+    display.setStepsPerTick(batches[i]);
+    CHECK_EQ(display.getStepsPerTick(), batches[i]);
+    display.showNumberDec(1234);
+    // A batch carries on across STOP/START: only the end of the frame cuts it short
+    CHECK_EQ(callsToIdle(display), (FRAME_STEPS + batches[i] - 1) / batches[i]);
+    CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+  }
+}
+
+TEST(batch_budget_spans_the_transactions_of_a_frame) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(0);
+  display.setStepsPerTick(28);  // One byte per call
+  display.showNumberDec(1234);
+  CHECK(!display.update());
+  CHECK_EQ(chip.takeLog(), "40");
+  CHECK(!display.update());        // Budget left over after the STOP, spent on the gap
+  CHECK_EQ(chip.transactions, 1);
+  for (uint8_t i = 0; i < 5; i++) CHECK(!display.update());
+  CHECK_EQ(chip.transactions, 2);
+  CHECK(display.update());         // 8 * 28 = 224: the last batch ran 21 steps
+  CHECK_EQ(chip.takeLog(), "C0 06 5B 4F 66 | 8F");
+}
+
+TEST(batch_stops_at_the_end_of_a_frame) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(0);
+  display.setStepsPerTick(100);
+  display.showNumberDec(1234);
+  CHECK(!display.update());
+  CHECK(!display.update());
+  display.showNumberDec(5678);     // Posted behind the frame in flight
+  CHECK(!display.update());        // 16 steps finish 1234, 5678 only starts
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+  CHECK_EQ(chip.ram[3], 0x66);
+  CHECK(!display.update());        // Its first 100 steps
+  CHECK(chip.takeLog() != "");
+  CHECK(display.pump());
+  CHECK_EQ(chip.ram[0], 0x6D);
+}
+
+#if TM1637_RETRIES
+TEST(batch_stops_for_the_bus_reset_gap) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(0);
+  display.setStepsPerTick(255);
+  chip.nackBytes = 1;
+  display.showNumberDec(1234);
+  CHECK(!display.update());        // NACK: the batch ends in the reset gap
+  CHECK_EQ(chip.takeLog(), "40?");
+  CHECK(callsToIdle(display) > 1);  // The gap is waited out call by call
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+}
+#endif
+
+TEST(tick_counted_pacing_reads_no_clock) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(100);
+  display.setTickPeriod(30);       // A step every 4th call: 120us >= 100us
+  display.showNumberDec(1234);
+  CHECK(!display.update());
+  unsigned long long now = bus::now();
+  for (uint8_t i = 0; i < 50; i++) CHECK(!display.update());
+#if !TM1637_TRACE
+  CHECK_EQ(bus::now(), now);       // Neither millis() nor micros() was read (the trace reads it)
+#endif
+  CHECK_EQ(51 + callsToIdle(display), 1 + 4 * (FRAME_STEPS - 1));
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+
+  display.setTickPeriod(0);        // Back to reading the clock
+  display.invalidate();
+  now = bus::now();
+  display.update();
+  CHECK(bus::now() != now);
+}
+
+TEST(tick_pacing_rounds_the_bit_delay_up) {
+  static const struct { uint16_t bitDelay; unsigned callsPerStep; } cases[] = {
+    { 0, 1 }, { 29, 1 }, { 30, 1 }, { 31, 2 }, { 90, 3 }, { 100, 4 },
+  };
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setTickPeriod(30);
+  display.showNumberDec(1234);
+  display.pump();
+  for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    display.setBitDelay(cases[i].bitDelay);
+    display.invalidate();
+    CHECK_EQ(callsToIdle(display), 1 + cases[i].callsPerStep * (FRAME_STEPS - 1));
+  }
+}
+
+#if TM1637_WATCHDOG
+TEST(tick_counted_watchdog) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(0);
+  display.setTickPeriod(100);
+  display.setTimeout(10);          // 100 ticks, half a frame
+  display.setRetries(0);
+  display.showNumberDec(1234);
+  unsigned calls = 0;
+  while (display.getError() == TM1637_ERR_NONE && calls < 1000) {
+    display.update();
+    calls++;
+  }
+  CHECK_EQ(calls, 101);
+  CHECK_EQ(display.getError(), TM1637_ERR_TIMEOUT);
+  CHECK(callsToIdle(display) > 1);  // Recovery STOP and gap, then no resend
+  CHECK_EQ(chip.takeLog(), "40 | C0 06");
+
+  display.setTimeout(22);          // 220 ticks: room for the whole frame
+  display.showNumberDec(5678);
+  CHECK_EQ(callsToIdle(display), FRAME_STEPS);
+  CHECK_EQ(chip.takeLog(), "40 | C0 6D 7D 07 7F | 8F");
+  CHECK_EQ(display.getError(), TM1637_ERR_NONE);
+}
+
+TEST(tick_watchdog_rounds_the_timeout_up) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(0);
+  display.setTickPeriod(300);
+  display.setTimeout(1);           // 1000us in 300us ticks: 4
+  display.setRetries(0);
+  display.showNumberDec(1234);
+  unsigned calls = 0;
+  while (display.getError() == TM1637_ERR_NONE && calls < 1000) {
+    display.update();
+    calls++;
+  }
+  CHECK_EQ(calls, 5);
+}
+#endif
+#endif
+
+TEST(service_sleeps_between_the_steps_of_a_frame) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  CHECK_EQ(display.timeUntilNextStep(), TM1637_NOTHING_DUE);
+  CHECK_EQ(display.service(), TM1637_NOTHING_DUE);
+
+  display.setBitDelay(100);
+  display.showNumberDec(1234);
+  unsigned services = 0;
+  uint32_t us;
+  while ((us = display.service()) != TM1637_NOTHING_DUE && services < 1000) {
+    CHECK(us > 0 && us <= 100);    // The rest of the bit delay, never a spin
+    bus::advance(us);
+    services++;
+  }
+  CHECK_EQ(services, FRAME_STEPS);  // One step per wake-up
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F");
+  CHECK_EQ(display.timeUntilNextStep(), TM1637_NOTHING_DUE);
+}
+
+#if TM1637_PACING && TM1637_RETRIES
+TEST(time_until_next_step_in_ticks_and_the_reset_gap) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(0);
+  display.setTickPeriod(50);
+  display.showNumberDec(1234);
+  display.update();
+  CHECK_EQ(display.timeUntilNextStep(), 50);  // Counted: the next tick
+  display.setTickPeriod(0);
+  CHECK(display.pump());
+  chip.takeLog();
+
+  chip.nackBytes = 1;
+  display.showNumberDec(5678);
+  for (uint8_t i = 0; i < 40; i++) display.update();
+  CHECK_EQ(chip.takeLog(), "40?");
+  uint32_t gap = display.timeUntilNextStep();  // Bus reset after the NACK
+  CHECK(gap > 1000 && gap <= 1200);
+  CHECK(display.pump());
+}
+#endif
+
+#if TM1637_THROTTLE
+TEST(time_until_next_step_ends_the_min_interval) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setMinInterval(50);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  uint32_t wait = display.timeUntilNextStep();  // isReadyForUpdate() then
+  CHECK(wait > 45000 && wait <= 50000);
+  bus::advance(wait);
+  CHECK_EQ(display.timeUntilNextStep(), TM1637_NOTHING_DUE);
+}
+#endif
+
+#if TM1637_SCROLL
+TEST(service_wakes_for_the_next_scroll_window) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  CHECK(display.startScroll("HELLO", 300));
+  CHECK_EQ(display.timeUntilNextStep(), 0);
+  uint32_t us = display.service();  // Sends the first window, blank
+  CHECK_EQ(chip.takeLog(), "40 | C0 00 00 00 00 | 8F");
+  CHECK(us > 290000 && us <= 300000);
+  bus::advance(us);
+  us = display.service();
+  CHECK_EQ(chip.takeLog(), "40 | C3 74");  // "   H"
+  CHECK(us > 290000 && us <= 300000);
+  display.stopScroll();
+  CHECK_EQ(display.timeUntilNextStep(), TM1637_NOTHING_DUE);
+}
+#endif
+
+#if TM1637_KEYS
+TEST(service_wakes_for_the_key_scan) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setKeyScan(20);
+  CHECK_EQ(display.timeUntilNextStep(), 0);
+  uint32_t us = display.service();
+  CHECK_EQ(chip.takeLog(), "42 FF");
+  CHECK(us > 15000 && us <= 20000);
+}
+#endif
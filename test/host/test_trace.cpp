@@ -0,0 +1,159 @@
+//  TM1637_TRACE step log: the CSV and VCD dumps (make -C test/host instrumented)
+
+#include <Arduino.h>
+#include <TM1637Display32.h>
+#include "BusModel.h"
+#include "TestRunner.h"
+#include <stdio.h>
+#include <vector>
+
+#if TM1637_TRACE
+
+#define CLK 2
+#define DIO 3
+
+class TextPrint : public Print {
+public:
+  std::string text;
+  size_t write(const char* data, size_t length) {
+    text.append(data, length);
+    return length;
+  }
+};
+
+struct TraceRow {
+  unsigned long t;
+  unsigned phase, counter, clk, dio;
+};
+
+static std::vector<TraceRow> csvRows(const std::string& csv) {
+  std::vector<TraceRow> rows;
+  size_t line = csv.find('\n') + 1;  // Past the header
+  while (line < csv.size()) {
+    TraceRow row;
+    if (sscanf(csv.c_str() + line, "%lu,%u,%u,%u,%u", &row.t, &row.phase, &row.counter,
+               &row.clk, &row.dio) == 5) rows.push_back(row);
+    line = csv.find('\n', line) + 1;
+    if (line == 0) break;
+  }
+  return rows;
+}
+
+// The bytes the traced line levels clock out, written like TM1637Model::takeLog()
+// (the master releases DIO for the ACK, so no '?' marks)
+static std::string decode(const std::vector<TraceRow>& rows) {
+  std::string log;
+  unsigned clk = 1, dio = 1, bit = 0, shift = 0;
+  bool inTx = false;
+  for (size_t i = 0; i < rows.size(); i++) {
+    if (clk && rows[i].clk && dio != rows[i].dio) {
+      inTx = !rows[i].dio;  // START: DIO falls with CLK HIGH, STOP: it rises
+      if (inTx) {
+        if (!log.empty()) log += " |";
+        bit = shift = 0;
+      }
+    } else if (inTx && !clk && rows[i].clk) {
+      if (bit < 8) shift |= rows[i].dio << bit;
+      if (++bit == 9) {
+        char hex[4];
+        snprintf(hex, sizeof(hex), " %02X", shift);
+        log += hex;
+        bit = shift = 0;
+      }
+    }
+    clk = rows[i].clk;
+    dio = rows[i].dio;
+  }
+  return log.empty() ? log : log.substr(1);
+}
+
+TEST(trace_csv_follows_the_lines) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.setBitDelay(10);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+
+  TextPrint out;
+  display.dumpTrace(out);
+  CHECK_EQ(out.text.substr(0, out.text.find('\n')), "t_us,phase,counter,clk,dio");
+  std::vector<TraceRow> rows = csvRows(out.text);
+  CHECK_EQ(rows.size(), 217);  // One row per step of the frame
+  CHECK_EQ(decode(rows), "40 | C0 06 5B 4F 66 | 8F");
+  CHECK_EQ(rows[0].t, 0);
+  unsigned long closest = 1000;
+  for (size_t i = 1; i < rows.size(); i++) {
+    if (rows[i].t - rows[i - 1].t < closest) closest = rows[i].t - rows[i - 1].t;
+  }
+  CHECK(closest >= 10);  // Paced by the bit delay
+
+  display.clearTrace();
+  out.text.clear();
+  display.dumpTrace(out);
+  CHECK_EQ(csvRows(out.text).size(), 0);
+}
+
+TEST(trace_vcd_declares_and_dumps_every_signal) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+
+  TextPrint csv, vcd;
+  display.dumpTrace(csv);
+  display.dumpTrace(vcd, true);
+  CHECK(vcd.text.find("$timescale 1us $end\n") == 0);
+  CHECK(vcd.text.find("$var wire 1 c CLK $end\n") != std::string::npos);
+  CHECK(vcd.text.find("$var wire 1 d DIO $end\n") != std::string::npos);
+  CHECK(vcd.text.find("$var reg 4 p phase $end\n") != std::string::npos);
+  CHECK(vcd.text.find("$var reg 8 s counter $end\n") != std::string::npos);
+  CHECK(vcd.text.find("$enddefinitions $end\n") != std::string::npos);
+
+  // The first step as a VCD block, and as many blocks as CSV rows
+  std::vector<TraceRow> rows = csvRows(csv.text);
+  char block[64];
+  snprintf(block, sizeof(block), "#0\n%uc\n%ud\nb%u%u%u%u p\nb%u%u%u%u%u%u%u%u s\n", rows[0].clk, rows[0].dio,
+           rows[0].phase >> 3 & 1, rows[0].phase >> 2 & 1, rows[0].phase >> 1 & 1, rows[0].phase & 1,
+           rows[0].counter >> 7 & 1, rows[0].counter >> 6 & 1, rows[0].counter >> 5 & 1,
+           rows[0].counter >> 4 & 1, rows[0].counter >> 3 & 1, rows[0].counter >> 2 & 1,
+           rows[0].counter >> 1 & 1, rows[0].counter & 1);
+  CHECK(vcd.text.find(block) != std::string::npos);
+  size_t blocks = 0;
+  for (size_t at = vcd.text.find("\n#"); at != std::string::npos; at = vcd.text.find("\n#", at + 1)) blocks++;
+  CHECK_EQ(blocks, rows.size());
+}
+
+#if TM1637_WAVE_CACHE
+TEST(trace_counts_replayed_steps_past_seven) {
+  TM1637Display32 display(CLK, DIO);
+  TM1637Model chip(CLK, DIO);
+  display.showNumberDec(1234);
+  CHECK(display.pump());
+  display.invalidate();  // The same transactions again, replayed from the cache
+  display.clearTrace();
+  CHECK(display.pump());
+  CHECK_EQ(chip.takeLog(), "40 | C0 06 5B 4F 66 | 8F | 40 | C0 06 5B 4F 66 | 8F");
+
+  TextPrint csv, vcd;
+  display.dumpTrace(csv);
+  display.dumpTrace(vcd, true);
+  std::vector<TraceRow> rows = csvRows(csv.text);
+  CHECK_EQ(decode(rows), "40 | C0 06 5B 4F 66 | 8F");
+  unsigned replayed = 0, highest = 0;
+  for (size_t i = 0; i < rows.size(); i++) {
+    if (rows[i].phase != 15) continue;
+    if (replayed > 0 && rows[i - 1].phase == 15) CHECK_EQ(rows[i].counter, rows[i - 1].counter + 1);
+    if (rows[i].counter > highest) highest = rows[i].counter;
+    replayed++;
+  }
+  CHECK(replayed > 100);  // The data block
+  CHECK(highest > 7);
+  char value[16];
+  snprintf(value, sizeof(value), "b%u%u%u%u%u%u%u%u s\n", highest >> 7 & 1, highest >> 6 & 1,
+           highest >> 5 & 1, highest >> 4 & 1, highest >> 3 & 1, highest >> 2 & 1,
+           highest >> 1 & 1, highest & 1);
+  CHECK(vcd.text.find(value) != std::string::npos);  // Not cut to the low bits
+}
+#endif
+
+#endif